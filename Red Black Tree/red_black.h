@@ -1,39 +1,689 @@
 #ifndef RED_BLACK_H
 #define RED_BLACK_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
-#include <queue>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility> // for std::pair
+#include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+// What a tree node stores: a key-value pair in a map, or only the key in a set (V = void)
+template <typename K, typename V>
+struct RB_Element {
+    using type = std::pair<K, V>;
+
+    static const K& key(const type& x) { return x.first; }
+    static void print(std::ostream& out, const type& x) { out << "(" << x.first << ", " << x.second << ")"; }
+};
+
+template <typename K>
+struct RB_Element<K, void> {
+    using type = K;
+
+    static const K& key(const type& x) { return x; }
+    static void print(std::ostream& out, const type& x) { out << x; }
+};
+
+// Key-storage policy: keys that support it keep a normalized integer prefix inline in each node, so most
+// comparisons during a search read only the node rather than the key's heap buffer. The default keeps no prefix.
+template <typename K, typename Comparator>
+struct RB_Key_Prefix {
+    using prefix_type = uint64_t;
+    struct slot {}; // Base of RB_Node; empty, so it takes no space
+
+    static prefix_type make(const K&) { return 0; }
+    static void store(slot&, const K&) {}
+    static prefix_type load(const slot&) { return 0; }
+
+    // Always undecided, so every comparison falls through to the comparator
+    static int compare(prefix_type, prefix_type) { return 0; }
+    static bool decisive(prefix_type) { return false; }
+};
+
+// Prefix of a byte string ordered like std::less: the first 7 bytes big-endian (zero padded), then a length tag
+// of min(size, 8). Integer order of prefixes matches string order whenever they differ, and keys of up to 7 bytes
+// are encoded completely, so two equal prefixes with a tag below 8 mean equal keys and the key is never read
+template <typename K>
+struct RB_String_Prefix {
+    using prefix_type = uint64_t;
+    struct slot {
+        prefix_type prefix = 0;
+    };
+
+    static prefix_type make(const K& key) {
+        prefix_type prefix = 0;
+        for (size_t i = 0; i < 7; i++) {
+            prefix = (prefix << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+        }
+        return (prefix << 8) | (key.size() < 8 ? key.size() : 8);
+    }
+    static void store(slot& s, const K& key) { s.prefix = make(key); }
+    static prefix_type load(const slot& s) { return s.prefix; }
+
+    static int compare(prefix_type a, prefix_type b) { return a < b ? -1 : (b < a ? 1 : 0); }
+    static bool decisive(prefix_type p) { return (p & 0xFF) < 8; }
+};
+
+template <> struct RB_Key_Prefix<std::string, std::less<std::string>> : RB_String_Prefix<std::string> {};
+#if __cplusplus >= 201402L
+template <> struct RB_Key_Prefix<std::string, std::less<>> : RB_String_Prefix<std::string> {};
+#endif
+#if __cplusplus >= 201703L
+template <> struct RB_Key_Prefix<std::string_view, std::less<std::string_view>> : RB_String_Prefix<std::string_view> {};
+template <> struct RB_Key_Prefix<std::string_view, std::less<>> : RB_String_Prefix<std::string_view> {};
+#endif
+
+// Open-addressing hash table from key to tree node, used by Red_Black_Tree for O(1) point lookups.
+// Linear probing over a power-of-two table kept at most half full, with backward-shift deletion so
+// no tombstones build up. Each slot caches its hash, so a probe rarely has to touch the node itself.
+// Nodes also keep their hash (node_base), so erase finds a node's slot without hashing its key, which
+// may already have been moved out.
+template <typename Node, typename Key, typename Element, typename Hash, typename Comparator>
+class RB_Hash_Index {
+    public:
+        // Base of the tree's node type
+        struct node_base {
+            uint64_t index_hash = 0;
+        };
+
+    private:
+        struct Slot {
+            uint64_t hash;
+            Node* node; // nullptr for an empty slot
+        };
+
+        std::vector<Slot> _slots;
+        size_t _count;
+        unsigned _bits; // log2 of the table size
+        Hash hasher;
+
+        // Spreads the hash (std::hash is the identity for integers) and keeps the top bits as the home slot
+        uint64_t hashOf(const Key& key) const {
+            return static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+        }
+        size_t home(uint64_t hash) const {
+            return static_cast<size_t>(hash >> (64 - _bits));
+        }
+
+        void place(uint64_t hash, Node* node) {
+            size_t mask = _slots.size() - 1;
+            size_t i = home(hash);
+
+            while (_slots[i].node != nullptr) {
+                i = (i + 1) & mask;
+            }
+
+            _slots[i].hash = hash;
+            _slots[i].node = node;
+        }
+
+        void grow() {
+            std::vector<Slot> old;
+            old.swap(_slots);
+
+            _bits = old.empty() ? 4 : _bits + 1;
+            _slots.assign(size_t(1) << _bits, Slot{0, nullptr});
+
+            for (const Slot& slot : old) {
+                if (slot.node != nullptr) {
+                    place(slot.hash, slot.node);
+                }
+            }
+        }
+
+    public:
+        static constexpr bool enabled = true;
+
+        RB_Hash_Index(): _count(0), _bits(0) {}
+
+        void clear() {
+            _slots.clear();
+            _count = 0;
+            _bits = 0;
+        }
+
+        void swap(RB_Hash_Index& other) noexcept {
+            _slots.swap(other._slots);
+            std::swap(_count, other._count);
+            std::swap(_bits, other._bits);
+            std::swap(hasher, other.hasher);
+        }
+
+        // Node whose key is equivalent to key under comp, or nullptr
+        Node* find(const Key& key, const Comparator& comp) const {
+            if (_count == 0) {
+                return nullptr;
+            }
+
+            uint64_t hash = hashOf(key);
+            size_t mask = _slots.size() - 1;
+
+            for (size_t i = home(hash); _slots[i].node != nullptr; i = (i + 1) & mask) {
+                const Key& other = Element::key(_slots[i].node->value);
+                if (_slots[i].hash == hash && !comp(key, other) && !comp(other, key)) {
+                    return _slots[i].node;
+                }
+            }
+
+            return nullptr;
+        }
+
+        void insert(Node* node) {
+            if ((_count + 1) * 2 > _slots.size()) {
+                grow();
+            }
+
+            node->index_hash = hashOf(Element::key(node->value));
+            place(node->index_hash, node);
+            _count++;
+        }
+
+        void erase(Node* node) {
+            uint64_t hash = node->index_hash;
+            size_t mask = _slots.size() - 1;
+            size_t i = home(hash);
+
+            while (_slots[i].node != node) {
+                i = (i + 1) & mask;
+            }
+
+            // Pull later entries of the probe run back into the hole, unless their home slot lies after it
+            for (size_t j = (i + 1) & mask; _slots[j].node != nullptr; j = (j + 1) & mask) {
+                size_t k = home(_slots[j].hash);
+                bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+
+                if (!stays) {
+                    _slots[i] = _slots[j];
+                    i = j;
+                }
+            }
+
+            _slots[i].node = nullptr;
+            _count--;
+        }
+};
+
+// A tree without a Hash type keeps no side index; every operation is a no-op
+template <typename Node, typename Key, typename Element, typename Comparator>
+class RB_Hash_Index<Node, Key, Element, void, Comparator> {
+    public:
+        struct node_base {};
+
+        static constexpr bool enabled = false;
+
+        void clear() {}
+        void swap(RB_Hash_Index&) noexcept {}
+        Node* find(const Key&, const Comparator&) const { return nullptr; }
+        void insert(Node*) {}
+        void erase(Node*) {}
+};
+
+// Red-black balancing over node handles, written once for every tree layout.
+// Links supplies a handle type node whose value-initialized value is null; left, right, parent and isRed
+// (false for null); setLeft, setRight, setParent and setRed; and root and setRoot. Red_Black_Tree passes raw
+// pointers, and Disk_Red_Black_Tree passes node numbers whose accessors load and store pages
+template <typename Links>
+struct RB_Balance {
+    using node = typename Links::node;
+
+    // In-order neighbours of a node, found through the parent links
+    template <typename Node>
+    static Node successor(const Links& links, Node n) {
+        if (links.right(n) != Node()) {
+            n = links.right(n);
+            while (links.left(n) != Node()) { n = links.left(n); }
+            return n;
+        }
+
+        Node p = links.parent(n);
+        while (p != Node() && n == links.right(p)) {
+            n = p;
+            p = links.parent(p);
+        }
+        return p;
+    }
+
+    template <typename Node>
+    static Node predecessor(const Links& links, Node n) {
+        if (links.left(n) != Node()) {
+            n = links.left(n);
+            while (links.right(n) != Node()) { n = links.right(n); }
+            return n;
+        }
+
+        Node p = links.parent(n);
+        while (p != Node() && n == links.left(p)) {
+            n = p;
+            p = links.parent(p);
+        }
+        return p;
+    }
+
+    // Puts newChild in the slot of parent that held oldChild (or the root slot)
+    static void replaceChild(Links links, node parent, node oldChild, node newChild) {
+        if (parent == node()) {
+            links.setRoot(newChild);
+        } else if (links.left(parent) == oldChild) {
+            links.setLeft(parent, newChild);
+        } else {
+            links.setRight(parent, newChild);
+        }
+    }
+
+    // Replaces the subtree rooted at oldNode with the one rooted at newNode
+    static void transplant(Links links, node oldNode, node newNode) {
+        node parent = links.parent(oldNode);
+        replaceChild(links, parent, oldNode, newNode);
+
+        if (newNode != node()) {
+            links.setParent(newNode, parent);
+        }
+    }
+
+    // Function for a right rotation
+    // Rotations keep the in-order sequence, so cached leftmost and rightmost nodes stay valid
+    static void rightRotation(Links links, node root) {
+        node newRoot = links.left(root);
+        node temp = links.right(newRoot);
+        node parent = links.parent(root);
+
+        links.setLeft(root, temp);
+        if (temp != node()) { links.setParent(temp, root); }
+        links.setParent(newRoot, parent);
+        replaceChild(links, parent, root, newRoot);
+        links.setRight(newRoot, root);
+        links.setParent(root, newRoot);
+    }
+
+    // Function for a left rotation
+    static void leftRotation(Links links, node root) {
+        node newRoot = links.right(root);
+        node temp = links.left(newRoot);
+        node parent = links.parent(root);
+
+        links.setRight(root, temp);
+        if (temp != node()) { links.setParent(temp, root); }
+        links.setParent(newRoot, parent);
+        replaceChild(links, parent, root, newRoot);
+        links.setLeft(newRoot, root);
+        links.setParent(root, newRoot);
+    }
+
+    // Function for recoloring a node and its children
+    static void recolor(Links links, node root) {
+        links.setRed(root, true);
+        links.setRed(links.left(root), false);
+        links.setRed(links.right(root), false);
+    }
+
+    // Restores the red-black properties after inserting a red node, walking up from it
+    // Uses at most two rotations; recoloring may continue towards the root
+    static void insertFixup(Links links, node n) {
+        while (links.isRed(links.parent(n))) {
+            node parent = links.parent(n);
+            node grandparent = links.parent(parent); // A red node is never the root
+
+            if (parent == links.left(grandparent)) {
+                if (links.isRed(links.right(grandparent))) { // Uncle is red (recolor)
+                    recolor(links, grandparent);
+                    n = grandparent;
+                } else {
+                    if (n == links.right(parent)) { // Double right rotation
+                        leftRotation(links, parent);
+                        parent = n;
+                    }
+
+                    rightRotation(links, grandparent);
+                    links.setRed(parent, false);
+                    links.setRed(grandparent, true);
+                    break;
+                }
+            } else {
+                if (links.isRed(links.left(grandparent))) { // Uncle is red (recolor)
+                    recolor(links, grandparent);
+                    n = grandparent;
+                } else {
+                    if (n == links.left(parent)) { // Double left rotation
+                        rightRotation(links, parent);
+                        parent = n;
+                    }
+
+                    leftRotation(links, grandparent);
+                    links.setRed(parent, false);
+                    links.setRed(grandparent, true);
+                    break;
+                }
+            }
+        }
+
+        // Root must be black
+        links.setRed(links.root(), false);
+    }
+
+    // Restores the red-black properties after removing a black node
+    // n carries the extra black and may be null, so its parent is passed separately
+    // Uses at most three rotations, with amortized O(1) recolorings over a sequence of erases
+    static void eraseFixup(Links links, node n, node parent) {
+        while (n != links.root() && !links.isRed(n)) {
+            if (n == links.left(parent)) {
+                node sibling = links.right(parent);
+
+                if (links.isRed(sibling)) {
+                    links.setRed(sibling, false);
+                    links.setRed(parent, true);
+                    leftRotation(links, parent);
+                    sibling = links.right(parent);
+                }
+
+                if (!links.isRed(links.left(sibling)) && !links.isRed(links.right(sibling))) {
+                    links.setRed(sibling, true);
+                    n = parent;
+                    parent = links.parent(n);
+                } else {
+                    if (!links.isRed(links.right(sibling))) {
+                        links.setRed(links.left(sibling), false);
+                        links.setRed(sibling, true);
+                        rightRotation(links, sibling);
+                        sibling = links.right(parent);
+                    }
+
+                    links.setRed(sibling, links.isRed(parent));
+                    links.setRed(parent, false);
+                    links.setRed(links.right(sibling), false);
+                    leftRotation(links, parent);
+                    n = links.root();
+                }
+            } else {
+                node sibling = links.left(parent);
+
+                if (links.isRed(sibling)) {
+                    links.setRed(sibling, false);
+                    links.setRed(parent, true);
+                    rightRotation(links, parent);
+                    sibling = links.left(parent);
+                }
+
+                if (!links.isRed(links.left(sibling)) && !links.isRed(links.right(sibling))) {
+                    links.setRed(sibling, true);
+                    n = parent;
+                    parent = links.parent(n);
+                } else {
+                    if (!links.isRed(links.left(sibling))) {
+                        links.setRed(links.right(sibling), false);
+                        links.setRed(sibling, true);
+                        leftRotation(links, sibling);
+                        sibling = links.left(parent);
+                    }
+
+                    links.setRed(sibling, links.isRed(parent));
+                    links.setRed(parent, false);
+                    links.setRed(links.left(sibling), false);
+                    rightRotation(links, parent);
+                    n = links.root();
+                }
+            }
+        }
+
+        if (n != node()) {
+            links.setRed(n, false);
+        }
+    }
+
+    // Unlinks n from the tree and restores the red-black properties. Only the links of n are read, and
+    // they are left as they were, so the caller frees n afterwards
+    static void erase(Links links, node n) {
+        node left = links.left(n);
+        node right = links.right(n);
+        node child; // Node that moves into the removed position (may be null)
+        node childParent;
+        bool removedRed = links.isRed(n);
+
+        if (left == node()) {
+            child = right;
+            childParent = links.parent(n);
+            transplant(links, n, child);
+        } else if (right == node()) {
+            child = left;
+            childParent = links.parent(n);
+            transplant(links, n, child);
+        } else { // Two children: the in-order successor takes the node's place
+            node next = right;
+            while (links.left(next) != node()) { next = links.left(next); }
+
+            removedRed = links.isRed(next);
+            child = links.right(next);
+
+            if (links.parent(next) == n) {
+                childParent = next;
+            } else {
+                childParent = links.parent(next);
+                transplant(links, next, child);
+                links.setRight(next, right);
+                links.setParent(right, next);
+            }
+
+            transplant(links, n, next);
+            links.setLeft(next, left);
+            links.setParent(left, next);
+            links.setRed(next, links.isRed(n));
+        }
+
+        if (!removedRed) {
+            eraseFixup(links, child, childParent);
+        }
+    }
+};
+
+// Output formats for Red_Black_Tree::dump
+enum class RB_Dump_Format {
+    Level, // One line per level of key[color] entries, with X for a missing child of the level above
+    Dot,   // Graphviz digraph
+    Json   // {"nodes": [...], "truncated": bool} with node ids in level order
+};
+
+// Collects dump output in memory and hands it to the stream in large chunks, so a big dump costs
+// a few stream writes instead of several per node (and never a flush per line)
+class RB_Dump_Sink {
+    public:
+        static constexpr std::streamoff chunk = 1 << 16;
+
+        explicit RB_Dump_Sink(std::ostream& out): _out(out) {}
+        ~RB_Dump_Sink() { flush(); }
+
+        RB_Dump_Sink(const RB_Dump_Sink&) = delete;
+        RB_Dump_Sink& operator=(const RB_Dump_Sink&) = delete;
+
+        std::ostream& stream() { return _buffer; }
+
+        // Passes the buffer on once it holds a full chunk
+        void maybeFlush() {
+            if (_buffer.tellp() >= chunk) {
+                flush();
+            }
+        }
+
+        void flush() {
+            _out << _buffer.str();
+            _buffer.str(std::string());
+        }
+
+    private:
+        std::ostream& _out;
+        std::ostringstream _buffer;
+};
 
 // This class describes a self-balancing binary tree using red-black balancing techniques.
-// The tree holds key-value pairs, and thus can function like a dictionary (without deletion currently)
-template <typename K, typename V, typename Comparator = std::less<K>>
+// The tree holds key-value pairs, and thus can function like a dictionary. With V = void the nodes hold
+// only keys and the tree is a set (see Red_Black_Set)
+// When Multi is true, equal keys are kept as separate nodes in insertion order instead of being overwritten
+// When Hash is not void, a hash side index from key to node turns find, contains and erase by key into one probe
+template <typename K, typename V, typename Comparator = std::less<K>, bool Multi = false, typename Hash = void>
 class Red_Black_Tree {
+    static_assert(!Multi || std::is_void<Hash>::value, "The hash side index requires unique keys");
+
     public:
         using key_type = K;
         using value_type = V;
         using key_compare = Comparator;
-        using pair = std::pair<key_type, value_type>;
+        using pair = typename RB_Element<K, V>::type; // The stored element; just the key in a set
 
     private:
+        using element = RB_Element<K, V>;
+
+        // Return type of the value accessors, which only exist in a map
+        template <typename T>
+        using mapped_reference = typename std::enable_if<!std::is_void<T>::value, T&>::type;
+
+        static const key_type& keyOf(const pair& x) { return element::key(x); }
+
         // Color type to describe if a node is black or red
-        enum class Color {Red, Black};
+        enum class Color : unsigned char {Red, Black};
+
+        using prefix_policy = RB_Key_Prefix<K, Comparator>;
+        using prefix_type = typename prefix_policy::prefix_type;
+
+        struct RB_Node;
+        using index_type = RB_Hash_Index<RB_Node, K, element, Hash, Comparator>;
 
         // Node for Red-Black Tree
-        struct RB_Node {
+        // color sits next to value so it can share the value's tail padding (a set of ints needs 32 bytes, not 40)
+        // The prefix_policy base holds the inline key prefix for string keys, and the index_type base the
+        // node's hash when there is a side index; both are empty otherwise
+        struct RB_Node : prefix_policy::slot, index_type::node_base {
             pair value;
+            Color color;
+            uint16_t block; // 1 + index in _blocks if the node lives in a block made by a copy, 0 for its own allocation
             RB_Node* left_child;
             RB_Node* right_child;
-            Color color;
+            RB_Node* parent;
+
+            RB_Node(pair value = pair(), RB_Node* left_child = nullptr, RB_Node* right_child = nullptr, Color color = Color::Red, RB_Node* parent = nullptr)
+             : value{std::move(value)}, color{color}, block{0}, left_child{left_child}, right_child{right_child}, parent{parent} {
+                prefix_policy::store(*this, keyOf(this->value));
+            }
+            RB_Node(const RB_Node& other)
+             : prefix_policy::slot(other), index_type::node_base(other), value{other.value}, color{other.color}, block{0},
+               left_child{nullptr}, right_child{nullptr}, parent{nullptr} {}
+        };
+
+        // Node-handle accessors for RB_Balance. The getters also take const nodes, for const iterators
+        struct Links {
+            using node = RB_Node*;
+
+            Red_Black_Tree* tree; // Only needed for the root
+
+            template <typename Node> static Node* left(Node* n) { return n->left_child; }
+            template <typename Node> static Node* right(Node* n) { return n->right_child; }
+            template <typename Node> static Node* parent(Node* n) { return n->parent; }
+            static bool isRed(const RB_Node* n) { return n != nullptr && n->color == Color::Red; }
+
+            static void setLeft(RB_Node* n, RB_Node* child) { n->left_child = child; }
+            static void setRight(RB_Node* n, RB_Node* child) { n->right_child = child; }
+            static void setParent(RB_Node* n, RB_Node* p) { n->parent = p; }
+            static void setRed(RB_Node* n, bool red) { n->color = red ? Color::Red : Color::Black; }
+
+            RB_Node* root() const { return tree->_root; }
+            void setRoot(RB_Node* n) const { tree->_root = n; }
+        };
+
+        using balance = RB_Balance<Links>;
+
+        // In-order neighbours of a node
+        template <typename Node>
+        static Node* successor(Node* n) { return balance::successor(Links{nullptr}, n); }
+        template <typename Node>
+        static Node* predecessor(Node* n) { return balance::predecessor(Links{nullptr}, n); }
+
+    public:
+        // Bidirectional in-order iterator over the key-value pairs
+        // The key of a pair must not be modified through an iterator
+        template <bool Const>
+        class RB_Iterator {
+            friend class Red_Black_Tree;
+            template <bool> friend class RB_Iterator;
+
+            using node_pointer = typename std::conditional<Const, const RB_Node*, RB_Node*>::type;
+            using tree_pointer = typename std::conditional<Const, const Red_Black_Tree*, Red_Black_Tree*>::type;
+
+            node_pointer node; // nullptr for end()
+            tree_pointer tree;
+
+            RB_Iterator(node_pointer node, tree_pointer tree): node{node}, tree{tree} {}
+
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = pair;
+                using difference_type = std::ptrdiff_t;
+                using pointer = typename std::conditional<Const, const pair*, pair*>::type;
+                using reference = typename std::conditional<Const, const pair&, pair&>::type;
+
+                RB_Iterator(): node{nullptr}, tree{nullptr} {}
+
+                // Conversion from iterator to const_iterator
+                template <bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+                RB_Iterator(const RB_Iterator<OtherConst>& other): node{other.node}, tree{other.tree} {}
+
+                reference operator*() const { return node->value; }
+                pointer operator->() const { return &node->value; }
 
-            RB_Node(pair value = pair(), RB_Node* left_child = nullptr, RB_Node* right_child = nullptr, Color color = Color::Red)
-             : value{value}, left_child{left_child}, right_child{right_child}, color{color} {}
-            RB_Node(RB_Node& other)
-             : value{other.value}, left_child{nullptr}, right_child{nullptr}, color{other.color} {}
+                RB_Iterator& operator++() {
+                    node = successor(node);
+                    return *this;
+                }
+                RB_Iterator operator++(int) {
+                    RB_Iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                // Decrementing end() moves to the largest node
+                RB_Iterator& operator--() {
+                    if (node == nullptr) {
+                        node = tree->_rightmost;
+                    } else {
+                        node = predecessor(node);
+                    }
+                    return *this;
+                }
+                RB_Iterator operator--(int) {
+                    RB_Iterator temp = *this;
+                    --*this;
+                    return temp;
+                }
+
+                friend bool operator==(const RB_Iterator& a, const RB_Iterator& b) { return a.node == b.node; }
+                friend bool operator!=(const RB_Iterator& a, const RB_Iterator& b) { return a.node != b.node; }
+        };
+
+        using iterator = RB_Iterator<false>;
+        using const_iterator = RB_Iterator<true>;
+
+    private:
+
+        // A run of nodes allocated together by a copy. Erased slots form a free list through their first bytes
+        struct RB_Block {
+            RB_Node* nodes; // nullptr once every node in it has been erased
+            size_t capacity;
+            size_t live;
+            RB_Node* free;
         };
 
         // Converts enum Color to a string
-        std::string color_string(Color c) {
+        static std::string color_string(Color c) {
             switch(c) {
                 case Color::Red:
                     return "Red";
@@ -51,8 +701,13 @@ class Red_Black_Tree {
         //////////////////////
 
         RB_Node* _root;
+        RB_Node* _leftmost;  // Smallest node, kept up to date by insert and erase
+        RB_Node* _rightmost; // Largest node
         size_t _size;
         key_compare comp;
+        index_type _index; // Empty unless Hash is given
+        std::vector<RB_Block> _blocks; // Node blocks made by copies; each is freed when its last node is
+        std::vector<uint16_t> _reusable; // Indices of live blocks with erased slots
 
 
 
@@ -62,17 +717,139 @@ class Red_Black_Tree {
         // PRIVATE HELPER FUNCTIONS //
         //////////////////////////////
 
-        // Recursive helper function for copying a tree
-        RB_Node* copyHelper(RB_Node* otherRoot) {
-            if (otherRoot == nullptr) {
-                return nullptr;
+        // Copies the nodes of other in BFS order into blocks of at least 256 nodes, so a copy costs one
+        // allocation per block and a parent sits just before its children in memory. Each block is freed as
+        // soon as its last node is erased, so a mostly erased copy does not hold the whole allocation.
+        // The blocks double as the BFS queue: until a clone is visited, its left_child holds the source node
+        void cloneFrom(const Red_Black_Tree& other) {
+            if (other._root == nullptr) {
+                return;
             }
 
-            RB_Node* left = copyHelper(otherRoot->left_child);
-            RB_Node* right = copyHelper(otherRoot->right_child);
+            // Node indices are kept in uint16_t, so very large trees use larger blocks
+            size_t perBlock = (other._size + 0xFFFE) / 0xFFFF;
+            if (perBlock < 256) {
+                perBlock = 256;
+            }
+
+            std::allocator<RB_Node> allocator;
+            std::vector<RB_Block> blocks;
+            blocks.reserve((other._size + perBlock - 1) / perBlock);
+            _reusable.reserve(blocks.capacity());
+            auto at = [&blocks, perBlock](size_t i) { return blocks[i / perBlock].nodes + i % perBlock; };
+            size_t built = 0;
+
+            try {
+                for (size_t first = 0; first < other._size; first += perBlock) {
+                    size_t capacity = std::min(perBlock, other._size - first);
+                    blocks.push_back(RB_Block{allocator.allocate(capacity), capacity, capacity, nullptr});
+                }
 
-            return new RB_Node(otherRoot->value, left, right, otherRoot->color);
+                new (at(0)) RB_Node(*other._root);
+                at(0)->left_child = other._root;
+                built++;
+
+                for (size_t i = 0; i < built; i++) {
+                    RB_Node* node = at(i);
+                    const RB_Node* source = node->left_child;
+                    node->left_child = nullptr;
+                    node->block = static_cast<uint16_t>(i / perBlock + 1);
+
+                    for (RB_Node* sourceChild : {source->left_child, source->right_child}) {
+                        if (sourceChild == nullptr) {
+                            continue;
+                        }
+
+                        RB_Node* child = new (at(built)) RB_Node(*sourceChild);
+                        built++;
+                        child->parent = node;
+                        (sourceChild == source->left_child ? node->left_child : node->right_child) = child;
+                        child->left_child = sourceChild;
+                    }
+                }
+            } catch (...) {
+                for (size_t i = 0; i < built; i++) {
+                    at(i)->~RB_Node();
+                }
+                for (const RB_Block& block : blocks) {
+                    allocator.deallocate(block.nodes, block.capacity);
+                }
+                throw;
+            }
 
+            _blocks.swap(blocks);
+            _root = _blocks[0].nodes;
+            _size = other._size;
+        }
+
+        // Creates a node, reusing an erased slot of a copied block when there is one
+        template <typename... Args>
+        RB_Node* newNode(Args&&... args) {
+            if (_reusable.empty()) {
+                return new RB_Node(std::forward<Args>(args)...);
+            }
+
+            uint16_t index = _reusable.back();
+            RB_Block& block = _blocks[index];
+            RB_Node* slot = block.free;
+            RB_Node* next = *reinterpret_cast<RB_Node**>(slot);
+            RB_Node* node;
+
+            try {
+                node = new (slot) RB_Node(std::forward<Args>(args)...);
+            } catch (...) {
+                new (slot) RB_Node*(next); // Put the link back
+                throw;
+            }
+
+            node->block = static_cast<uint16_t>(index + 1);
+            block.free = next;
+            block.live++;
+            if (next == nullptr) {
+                _reusable.pop_back();
+            }
+            return node;
+        }
+
+        // Frees a node. A node of a copied block returns its slot to the block, and the block itself is
+        // freed with its last node
+        void deleteNode(RB_Node* node) {
+            if (node->block == 0) {
+                delete node;
+                return;
+            }
+
+            uint16_t index = static_cast<uint16_t>(node->block - 1);
+            RB_Block& block = _blocks[index];
+            node->~RB_Node();
+
+            if (--block.live == 0) {
+                if (block.free != nullptr) {
+                    _reusable.erase(std::find(_reusable.begin(), _reusable.end(), index));
+                }
+                std::allocator<RB_Node>().deallocate(block.nodes, block.capacity);
+                block.nodes = block.free = nullptr;
+                return;
+            }
+
+            if (block.free == nullptr) {
+                _reusable.push_back(index);
+            }
+            new (node) RB_Node*(block.free);
+            block.free = node;
+        }
+
+        // Frees the blocks that still hold nodes and forgets the rest; only called once no node is alive
+        void releaseBlocks() {
+            std::allocator<RB_Node> allocator;
+            for (const RB_Block& block : _blocks) {
+                if (block.nodes != nullptr) {
+                    allocator.deallocate(block.nodes, block.capacity);
+                }
+            }
+
+            _blocks.clear();
+            _reusable.clear();
         }
 
         // Recursive helper function for deleting a tree
@@ -91,81 +868,167 @@ class Red_Black_Tree {
                 node->right_child = nullptr;
             }
 
-            delete node;
+            deleteNode(node);
         }
 
-        // Recursive helper function for inserting a new node into a tree
-        void insertHelper(RB_Node* node, const pair& x) {
-            if (x.first == node->value.first) {
-                node->value = x;
-            } else if (comp(x.first, node->value.first)) { // If less than current node, move left
-                if (node->left_child == nullptr) {
-                    node->left_child = new RB_Node(x);
-                } else {
-                    insertHelper(node->left_child, x);
-                }
-            } else { // If more than current node, move right
-                if (node->right_child == nullptr) {
-                    node->right_child = new RB_Node(x);
-                } else {
-                    insertHelper(node->right_child, x);
+        // Key comparisons against a node, given the prefix px of x. The inline prefixes decide whenever they
+        // differ (or fully encode a short key); only ties fall back to the comparator and the full key
+        bool lessThanNode(const key_type& x, prefix_type px, const RB_Node* node) const {
+            int c = prefix_policy::compare(px, prefix_policy::load(*node));
+            if (c != 0 || prefix_policy::decisive(px)) {
+                return c < 0;
+            }
+            return comp(x, keyOf(node->value));
+        }
+
+        bool nodeLessThan(const RB_Node* node, const key_type& x, prefix_type px) const {
+            int c = prefix_policy::compare(prefix_policy::load(*node), px);
+            if (c != 0 || prefix_policy::decisive(px)) {
+                return c < 0;
+            }
+            return comp(keyOf(node->value), x);
+        }
+
+        // Helper function for inserting a new node into the subtree at start. Returns the node holding x
+        // start must be the root or a subtree whose key range holds x
+        template <typename P>
+        RB_Node* insertHelper(P&& x, RB_Node* start) {
+            RB_Node* parent = nullptr;
+            RB_Node* node = start;
+            bool goLeft = false;
+            prefix_type px = prefix_policy::make(keyOf(x));
+
+            while (node != nullptr) {
+                if (lessThanNode(keyOf(x), px, node)) { // If less than current node, move left
+                    goLeft = true;
+                } else if (!Multi && !nodeLessThan(node, keyOf(x), px)) { // Equal keys overwrite in a map
+                    node->value = std::forward<P>(x);
+                    return node;
+                } else { // If more than (or, in a multimap, equal to) current node, move right
+                    goLeft = false;
                 }
+
+                parent = node;
+                node = goLeft ? node->left_child : node->right_child;
+            }
+
+            node = newNode(std::forward<P>(x), nullptr, nullptr, Color::Red, parent);
+            _index.insert(node);
+            _size++;
+
+            if (parent == nullptr) {
+                _root = _leftmost = _rightmost = node;
+            } else if (goLeft) {
+                parent->left_child = node;
+                if (parent == _leftmost) { _leftmost = node; }
+            } else {
+                parent->right_child = node;
+                if (parent == _rightmost) { _rightmost = node; }
             }
+
+            balance::insertFixup(Links{this}, node);
+            return node;
         }
 
-        // Recursive helper function for inserting a new node into a tree
-        void insertHelper(RB_Node* node, pair&& x) {
-            if (x.first == node->value.first) {
-                node->value = std::move(x);
-            } else if (comp(x.first, node->value.first)) { // If less than current node, move left
-                if (node->left_child == nullptr) {
-                    node->left_child = new RB_Node(std::move(x));
-                } else {
-                    insertHelper(node->left_child, std::move(x));
+        // Removes a node from the side index, then unlinks and frees it
+        void eraseHelper(RB_Node* node) {
+            _index.erase(node);
+            unlinkHelper(node);
+        }
+
+        // Unlinks a node that is no longer indexed from the tree, frees it and restores the red-black properties
+        // Only the links are read, so the node's value may already have been moved out
+        void unlinkHelper(RB_Node* node) {
+            // The cached extremes have at most one child, so their neighbours are found in O(1)
+            if (node == _leftmost) { _leftmost = successor(node); }
+            if (node == _rightmost) { _rightmost = predecessor(node); }
+
+            balance::erase(Links{this}, node);
+            deleteNode(node);
+            _size--;
+
+            if (_size == 0) { // Every block has been freed; drop their records
+                releaseBlocks();
+            }
+        }
+
+        // Helper function for finding a node: one probe of the side index if there is one, then a tree search
+        // The index only finds keys that hash like the stored one, so a miss falls back to the tree, which
+        // also finds keys the Comparator treats as equal but the Hash does not (e.g. case-insensitive strings)
+        RB_Node* findHelper(const key_type& x) const {
+            if (index_type::enabled) {
+                RB_Node* hit = _index.find(x, comp);
+                if (hit != nullptr) {
+                    return hit;
                 }
-            } else { // If more than current node, move right
-                if (node->right_child == nullptr) {
-                    node->right_child = new RB_Node(std::move(x));
-                } else {
-                    insertHelper(node->right_child, std::move(x));
+            }
+
+            RB_Node* node = _root;
+            prefix_type px = prefix_policy::make(x);
+
+            while (node != nullptr) {
+                if (lessThanNode(x, px, node)) { // If current node is greater, go left
+                    node = node->left_child;
+                } else if (nodeLessThan(node, x, px)) { // If current node is smaller, go right
+                    node = node->right_child;
+                } else { // If at correct node, return it
+                    return node;
                 }
             }
+
+            return nullptr;
         }
 
-        // Recursive helper function for finding a value
-        RB_Node* findHelper(RB_Node* node, const key_type& x) {
-            if (node == nullptr) {
-                return nullptr;
+        // Rebuilds the side index from the nodes, after a copy
+        void reindex() {
+            _index.clear();
+            for (RB_Node* node = _leftmost; node != nullptr; node = successor(node)) {
+                _index.insert(node);
             }
+        }
+
+        // First node whose key is not less than x
+        RB_Node* lowerBoundHelper(const key_type& x) const {
+            RB_Node* node = _root;
+            RB_Node* result = nullptr;
+            prefix_type px = prefix_policy::make(x);
 
-            if (node->value.first == x) { // If at correct node, return it
-                return node;
-            } else if (comp(x, node->value.first)) { // If current node is greater, go left
-                return findHelper(node->left_child, x);
-            } else { // Otherwise, go right
-                return findHelper(node->right_child, x);
+            while (node != nullptr) {
+                if (nodeLessThan(node, x, px)) {
+                    node = node->right_child;
+                } else {
+                    result = node;
+                    node = node->left_child;
+                }
             }
+
+            return result;
         }
 
-        const RB_Node* findHelper(const RB_Node* node, const key_type& x) const {
-            if (node == nullptr) {
-                return nullptr;
-            }
+        // First node whose key is greater than x
+        RB_Node* upperBoundHelper(const key_type& x) const {
+            RB_Node* node = _root;
+            RB_Node* result = nullptr;
+            prefix_type px = prefix_policy::make(x);
 
-            if (node->value.first == x) { // If at correct node, return it
-                return node;
-            } else if (comp(x, node->value.first)) { // If current node is greater, go left
-                return findHelper(node->left_child, x);
-            } else { // Otherwise, go right
-                return findHelper(node->right_child, x);
+            while (node != nullptr) {
+                if (lessThanNode(x, px, node)) {
+                    result = node;
+                    node = node->left_child;
+                } else {
+                    node = node->right_child;
+                }
             }
+
+            return result;
         }
 
         // Traversal printing helpers
         void preorder(std::ostream& out, RB_Node* n) {
             if (!n) { return; }
 
-            out << "(" << n->value.first << ", " << n->value.second << ")[" << color_string(n->color) << "] " << std::endl;
+            element::print(out, n->value);
+            out << "[" << color_string(n->color) << "] " << std::endl;
             preorder(out, n->left_child);
             preorder(out, n->right_child);
         }
@@ -174,7 +1037,8 @@ class Red_Black_Tree {
             if (!n) { return; }
 
             inorder(out, n->left_child);
-            out << "(" << n->value.first << ", " << n->value.second << ")[" << color_string(n->color) << "] " << std::endl;
+            element::print(out, n->value);
+            out << "[" << color_string(n->color) << "] " << std::endl;
             inorder(out, n->right_child);
         }
 
@@ -183,7 +1047,56 @@ class Red_Black_Tree {
 
             postorder(out, n->left_child);
             postorder(out, n->right_child);
-            out << "(" << n->value.first << ", " << n->value.second << ")[" << color_string(n->color) << "] " << std::endl;
+            element::print(out, n->value);
+            out << "[" << color_string(n->color) << "] " << std::endl;
+        }
+
+        // Writes value as a quoted string, escaping quotes, backslashes and control characters (valid in JSON and DOT)
+        static void writeQuoted(std::ostream& out, const pair& value) {
+            std::ostringstream text;
+            element::print(text, value);
+
+            out << '"';
+            for (char c : text.str()) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    const char* hex = "0123456789abcdef";
+                    out << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+                } else {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+        // Writes one node for dump; children are given by id, SIZE_MAX for none
+        static void dumpNode(std::ostream& out, RB_Dump_Format format, const RB_Node* n, size_t id,
+                             size_t left, size_t right, size_t max_nodes) {
+            if (format == RB_Dump_Format::Level) {
+                element::print(out, n->value);
+                out << "[" << color_string(n->color) << "] ";
+            } else if (format == RB_Dump_Format::Dot) {
+                out << "    n" << id << " [label=";
+                writeQuoted(out, n->value);
+                out << ", color=" << (n->color == Color::Red ? "red" : "black") << "];\n";
+
+                // Edges to nodes past the cap would create unlabeled nodes
+                for (size_t child : {left, right}) {
+                    if (child < max_nodes) {
+                        out << "    n" << id << " -> n" << child << ";\n";
+                    }
+                }
+            } else {
+                out << (id > 0 ? ",\n" : "\n") << "  {\"id\": " << id << ", \"value\": ";
+                writeQuoted(out, n->value);
+                out << ", \"color\": \"" << color_string(n->color) << "\", \"left\": ";
+                // Children past the cap are not written, so they appear as null like missing ones
+                if (left < max_nodes) { out << left; } else { out << "null"; }
+                out << ", \"right\": ";
+                if (right < max_nodes) { out << right; } else { out << "null"; }
+                out << "}";
+            }
         }
 
 
@@ -194,162 +1107,125 @@ class Red_Black_Tree {
         // FUNCTIONS USED FOR BALANCING //
         //////////////////////////////////
 
-        // Function for a right rotation
-        RB_Node* rightRotation(RB_Node* root) {
-            RB_Node* temp = root->left_child->right_child;
-            RB_Node* newRoot = root->left_child;
-
-            root->left_child->right_child = root;
-            root->left_child = temp;
+        // Rotations and fixups live in RB_Balance, which Disk_Red_Black_Tree shares
 
-            return newRoot;
+        // Checks a cached extreme before it is used by min, max, pop_min or pop_max
+        static RB_Node* extremeHelper(RB_Node* node) {
+            if (node == nullptr) {
+                throw std::out_of_range("The tree is empty");
+            }
+            return node;
         }
 
-        // Function for a left rotation
-        RB_Node* leftRotation(RB_Node* root) {
-            RB_Node* temp = root->right_child->left_child;
-            RB_Node* newRoot = root->right_child;
+        // Recomputes the cached leftmost and rightmost nodes from the root
+        void resetExtremes() {
+            _leftmost = _rightmost = _root;
 
-            root->right_child->left_child = root;
-            root->right_child = temp;
-
-            return newRoot;
+            while (_leftmost != nullptr && _leftmost->left_child != nullptr) { _leftmost = _leftmost->left_child; }
+            while (_rightmost != nullptr && _rightmost->right_child != nullptr) { _rightmost = _rightmost->right_child; }
         }
 
-        // Function for recoloring a node and its children
-        void recolor(RB_Node* root) {
-            root->color = Color::Red;
-            root->left_child->color = Color::Black;
-            root->right_child->color = Color::Black;
+        // Walks up from the last inserted node to the smallest subtree whose key range holds x
+        // Batches are inserted in ascending order, so the climb stays short when keys are close together
+        RB_Node* batchStart(RB_Node* hint, const key_type& x) {
+            while (hint->parent != nullptr) {
+                if (hint == hint->parent->left_child && comp(x, keyOf(hint->parent->value))) {
+                    break;
+                }
+                hint = hint->parent;
+            }
+            return hint;
         }
 
-        // Recursive helper function for rebalancing a tree
-        RB_Node* rebalanceHelper(RB_Node* node) {
-
-            // No rebalancing if nullptr
-            if (node == nullptr) {
+        // Links nodes[lo, hi) into a balanced subtree and returns its root
+        // Only the nodes at redDepth (the deepest, possibly partial level) are red, so every path has the same black count
+        static RB_Node* buildHelper(std::vector<RB_Node*>& nodes, size_t lo, size_t hi, size_t depth, size_t redDepth, RB_Node* parent) {
+            if (lo == hi) {
                 return nullptr;
             }
 
-            // Assign left child to rebalanced left subtree
-            node->left_child = rebalanceHelper(node->left_child);
-
-            // Assign right child to rebalanced right subtree
-            node->right_child = rebalanceHelper(node->right_child);
-
-            if (node->left_child != nullptr && node->left_child->left_child != nullptr) {
-
-                if (node->left_child->color == Color::Red && node->left_child->left_child->color == Color::Red) {
+            size_t mid = lo + (hi - lo) / 2;
+            RB_Node* node = nodes[mid];
 
-                    if (node->right_child != nullptr && node->right_child->color == Color::Red) { // Uncle is red (recolor)
-                        recolor(node);
+            node->parent = parent;
+            node->color = depth == redDepth ? Color::Red : Color::Black;
+            node->left_child = buildHelper(nodes, lo, mid, depth + 1, redDepth, node);
+            node->right_child = buildHelper(nodes, mid + 1, hi, depth + 1, redDepth, node);
 
-                        return node;
-                    } else { // Right rotation
-                        RB_Node* newRoot = rightRotation(node);
-                        newRoot->color = Color::Black;
-                        node->color = Color::Red;
-
-                        return newRoot;
-                    }
-                }
-            } 
-            
-            if (node->left_child != nullptr && node->left_child->right_child != nullptr) {
-                if (node->left_child->color == Color::Red && node->left_child->right_child->color == Color::Red) {
-                    if (node->right_child != nullptr && node->right_child->color == Color::Red) { // Uncle is red (recolor)
-                        recolor(node);
-
-                        return node;
-                    } else { // Double right rotation
-                        node->left_child = leftRotation(node->left_child);
-                        RB_Node* newRoot = rightRotation(node);
-                        node->color = Color::Red;
-                        newRoot->color = Color::Black;
-
-                        return newRoot;
-                    }
-                }
-            } 
-            
-            if (node->right_child != nullptr && node->right_child->right_child != nullptr) {
-
-                if (node->right_child->color == Color::Red && node->right_child->right_child->color == Color::Red) {
-
-                    if (node->left_child != nullptr && node->left_child->color == Color::Red) { // Uncle is red (recolor)
-                        recolor(node);
-
-                        return node;
-                    } else { // Left rotation
-                        RB_Node* newRoot = leftRotation(node);
-                        newRoot->color = Color::Black;
-                        node->color = Color::Red;
+            return node;
+        }
 
-                        return newRoot;
-                    }
-                }
-            } 
-            
-            if (node->right_child != nullptr && node->right_child->left_child != nullptr) {
-                if (node->right_child->color == Color::Red && node->right_child->left_child->color == Color::Red) {
-                    if (node->left_child != nullptr && node->left_child->color == Color::Red) { // Uncle is red (recolor)
-                        recolor(node);
-
-                        return node;
-                    } else { // Double left rotation
-                        node->right_child = rightRotation(node->right_child);
-                        RB_Node* newRoot = leftRotation(node);
-                        node->color = Color::Red;
-                        newRoot->color = Color::Black;
-
-                        return newRoot;
+        // Merges a sorted batch with the tree's nodes in one pass and rebuilds a balanced tree in O(n + k)
+        void rebuildWithBatch(std::vector<pair>& batch) {
+            std::vector<RB_Node*> nodes;
+            nodes.reserve(_size + batch.size());
+
+            RB_Node* node = _leftmost;
+            size_t i = 0;
+
+            while (node != nullptr || i < batch.size()) {
+                if (i == batch.size() || (node != nullptr && comp(keyOf(node->value), keyOf(batch[i])))) {
+                    nodes.push_back(node);
+                    node = successor(node);
+                } else if (node != nullptr && !comp(keyOf(batch[i]), keyOf(node->value))) { // Equal keys
+                    if (Multi) { // Existing nodes come first to keep insertion order
+                        nodes.push_back(node);
+                        node = successor(node);
+                    } else {
+                        node->value = std::move(batch[i++]);
+                        nodes.push_back(node);
+                        node = successor(node);
                     }
+                } else {
+                    nodes.push_back(newNode(std::move(batch[i++])));
+                    _index.insert(nodes.back());
                 }
             }
 
-            // If no changes need to be made, return the subtree
-            return node;
-        }
-
-        // Function for rebalancing a tree
-        void rebalance() {
-            // New root after rebalancing
-            _root = rebalanceHelper(_root);
+            size_t redDepth = 0;
+            while ((size_t(2) << redDepth) <= nodes.size()) { redDepth++; } // floor(log2(n))
 
-            // Root must be black
-            if (_root->color != Color::Black) {
-                _root->color = Color::Black;
-            }
+            _size = nodes.size();
+            _root = buildHelper(nodes, 0, nodes.size(), 0, redDepth, nullptr);
+            _root->color = Color::Black;
+            _leftmost = nodes.front();
+            _rightmost = nodes.back();
         }
 
     public:
         // Checks if tree is empty
-        bool empty() {
+        bool empty() const {
             return _size == 0;
         }
 
         // Makes tree empty
         void clear() {
             deleteHelper(_root);
-            _root = nullptr;
+            releaseBlocks();
+            _index.clear();
+            _root = _leftmost = _rightmost = nullptr;
             _size = 0;
         }
 
         // Default constructor
-        Red_Black_Tree(): _root(nullptr), _size(0) {}
+        Red_Black_Tree(): _root(nullptr), _leftmost(nullptr), _rightmost(nullptr), _size(0) {}
 
         // Create tree with root
-        Red_Black_Tree(pair value): _root{value}, _size(1) {}
+        Red_Black_Tree(pair value): Red_Black_Tree() {
+            insert(std::move(value));
+        }
 
-        // Copy Constructor
-        Red_Black_Tree(Red_Black_Tree& other): _root{nullptr}, _size(other._size) {
-            _root = copyHelper(other._root);
+        // Copy Constructor; the copy's nodes are allocated in blocks of at least 256, each freed when its last node is erased
+        Red_Black_Tree(const Red_Black_Tree& other): Red_Black_Tree() {
+            comp = other.comp;
+            cloneFrom(other);
+            resetExtremes();
+            reindex();
         }
 
         // Move Constructor
-        Red_Black_Tree(Red_Black_Tree&& other): _root(other._root), _size(other._size) {
-            other._root = nullptr;
-            other._size = 0;
+        Red_Black_Tree(Red_Black_Tree&& other) noexcept: Red_Black_Tree() {
+            swap(other);
         }
 
         // Destructor
@@ -357,84 +1233,210 @@ class Red_Black_Tree {
             clear();
         }
 
-        // Copy Assignment
-        Red_Black_Tree& operator=(Red_Black_Tree& other) {
-            if (this == &other) {
-                return *this;
+        // Copy Assignment; copies into a temporary first, so this tree is unchanged if copying throws
+        Red_Black_Tree& operator=(const Red_Black_Tree& other) {
+            if (this != &other) {
+                Red_Black_Tree copy(other);
+                swap(copy);
             }
-            
-            if (!empty()) {
+
+            return *this;
+        }
+
+        // Move Assignment; other is left empty
+        Red_Black_Tree& operator=(Red_Black_Tree&& other) noexcept {
+            if (this != &other) {
                 clear();
+                swap(other);
             }
 
-            _root = copyHelper(other._root);
-            _size = other._size;
-
             return *this;
         }
 
-        // Move Assignment
-        Red_Black_Tree& operator=(Red_Black_Tree&& other) {
-            if (this == &other) {
-                return *this;
+        // Exchanges the contents of two trees without copying or allocating
+        void swap(Red_Black_Tree& other) noexcept {
+            std::swap(_root, other._root);
+            std::swap(_leftmost, other._leftmost);
+            std::swap(_rightmost, other._rightmost);
+            std::swap(_size, other._size);
+            std::swap(comp, other.comp);
+            _index.swap(other._index);
+            _blocks.swap(other._blocks);
+            _reusable.swap(other._reusable);
+        }
+
+        friend void swap(Red_Black_Tree& a, Red_Black_Tree& b) noexcept {
+            a.swap(b);
+        }
+
+        // Returns the number of nodes in the tree
+        size_t size() const { return _size; }
+        size_t count() const { return _size; }
+
+        // Returns the number of nodes with the given key in O(log n + k)
+        size_t count(const key_type& key) const {
+            size_t n = 0;
+            for (const_iterator it = lower_bound(key), last = upper_bound(key); it != last; ++it) {
+                n++;
             }
+            return n;
+        }
 
-            if (!empty()) {
-                clear();
+        // Insert value into tree and rebalance
+        void insert(const pair& x) { insertHelper(x, _root); }
+        void insert(pair&& x) { insertHelper(std::move(x), _root); }
+
+        // Insert an unsorted batch of pairs with one sort instead of a full search per pair
+        // Small batches are inserted in ascending order starting from the previous insert position;
+        // batches of at least a quarter of the tree's size are merged and rebuilt in O(n + k)
+        // Equal keys within the batch resolve the same way as repeated insert calls
+        void insert_batch(std::vector<pair>&& batch) {
+            if (batch.empty()) {
+                return;
             }
 
-            _root = other._root;
-            _size = other._size;
-            other._root = nullptr;
-            other._size = 0;
+            std::stable_sort(batch.begin(), batch.end(), [this](const pair& a, const pair& b) { return comp(keyOf(a), keyOf(b)); });
 
-            return *this;
+            if (!Multi) { // Keep only the last pair of each run of equal keys
+                size_t kept = 0;
+                for (size_t i = 0; i < batch.size(); i++) {
+                    if (i + 1 < batch.size() && !comp(keyOf(batch[i]), keyOf(batch[i + 1]))) {
+                        continue;
+                    }
+                    if (kept != i) {
+                        batch[kept] = std::move(batch[i]);
+                    }
+                    kept++;
+                }
+                batch.erase(batch.begin() + kept, batch.end());
+            }
+
+            if (_size <= 4 * batch.size()) {
+                rebuildWithBatch(batch);
+                return;
+            }
+
+            RB_Node* hint = _root;
+            for (pair& x : batch) {
+                RB_Node* start = batchStart(hint, keyOf(x));
+                hint = insertHelper(std::move(x), start);
+            }
         }
 
-        // Returns the number of nodes in the tree
-        size_t size() { return _size; }
-        size_t count() { return _size; }
+        template <typename InputIt>
+        void insert_batch(InputIt first, InputIt last) {
+            insert_batch(std::vector<pair>(first, last));
+        }
 
-        // Insert value into tree
-        void insert(const pair& x) {
-            if (_root == nullptr) { // Add root if tree is empty
-                _root = new RB_Node(x);
-                _root->color = Color::Black;
+#if __cplusplus >= 202002L
+        void insert_batch(std::span<const pair> batch) {
+            insert_batch(std::vector<pair>(batch.begin(), batch.end()));
+        }
+#endif
+
+        // Remove every node with the given key. Returns the number of nodes removed
+        size_t erase(const key_type& key) {
+            if (!Multi) {
+                RB_Node* node = findHelper(key);
+                if (node == nullptr) {
+                    return 0;
+                }
 
-            } else { // Insert and rebalance
-                insertHelper(_root, x);
-                rebalance();
+                eraseHelper(node);
+                return 1;
             }
 
-            _size++;
+            size_t removed = 0;
+            RB_Node* node = lowerBoundHelper(key);
+
+            while (node != nullptr && !comp(key, keyOf(node->value))) {
+                RB_Node* next = successor(node);
+                eraseHelper(node);
+                node = next;
+                removed++;
+            }
+
+            return removed;
+        }
+
+        // Remove the node at pos. Returns an iterator to the node after it
+        iterator erase(iterator pos) {
+            RB_Node* next = successor(pos.node);
+            eraseHelper(pos.node);
+            return iterator(next, this);
+        }
+
+        // Smallest and largest pairs in O(1). The tree must not be empty
+        pair& min() { return extremeHelper(_leftmost)->value; }
+        const pair& min() const { return extremeHelper(_leftmost)->value; }
+        pair& max() { return extremeHelper(_rightmost)->value; }
+        const pair& max() const { return extremeHelper(_rightmost)->value; }
+
+        // Remove and return the smallest or largest pair
+        // The node leaves the side index before its value is moved out
+        pair pop_min() {
+            RB_Node* node = extremeHelper(_leftmost);
+            _index.erase(node);
+            pair x = std::move(node->value);
+            unlinkHelper(node);
+            return x;
+        }
+        pair pop_max() {
+            RB_Node* node = extremeHelper(_rightmost);
+            _index.erase(node);
+            pair x = std::move(node->value);
+            unlinkHelper(node);
+            return x;
         }
 
-        // Insert value into tree
-        void insert(pair&& x) {
-            if (_root == nullptr) { // Add root if tree is empty
-                _root = new RB_Node(std::move(x));
-                _root->color = Color::Black;
+        // Remove every pair whose key is not greater than key, smallest first, passing each one to fn
+        // Returns the number of pairs removed
+        template <typename Function>
+        size_t drain_until(const key_type& key, Function fn) {
+            size_t removed = 0;
 
-            } else { // Insert and rebalance
-                insertHelper(_root, std::move(x));
-                rebalance();
+            while (_leftmost != nullptr && !comp(key, keyOf(_leftmost->value))) {
+                fn(pop_min());
+                removed++;
             }
 
-            _size++;
+            return removed;
         }
 
         // Returns true if value is in tree
         bool contains(const key_type& x) const {
-            return findHelper(_root, x) != nullptr;
+            return findHelper(x) != nullptr;
         }
 
-        // Find a value in the tree with a given key
-        value_type& find(const key_type& key) { return findHelper(_root, key )->value.second; }
-        const value_type& find(const key_type& key) const { return findHelper(_root, key)->value.second; }
-
-        // Bracket access operator
-        value_type& operator[](const key_type& key) { return findHelper(_root, key )->value.second; }
-        const value_type& operator[](const key_type& key) const { return findHelper(_root, key)->value.second; }
+        // Find a value in the tree with a given key (maps only)
+        template <typename T = V>
+        mapped_reference<T> find(const key_type& key) { return findHelper(key)->value.second; }
+        template <typename T = V>
+        mapped_reference<const T> find(const key_type& key) const { return findHelper(key)->value.second; }
+
+        // Bracket access operator (maps only)
+        template <typename T = V>
+        mapped_reference<T> operator[](const key_type& key) { return findHelper(key)->value.second; }
+        template <typename T = V>
+        mapped_reference<const T> operator[](const key_type& key) const { return findHelper(key)->value.second; }
+
+        // In-order iteration
+        iterator begin() { return iterator(_leftmost, this); }
+        const_iterator begin() const { return const_iterator(_leftmost, this); }
+        iterator end() { return iterator(nullptr, this); }
+        const_iterator end() const { return const_iterator(nullptr, this); }
+
+        // Range lookups; in a multimap, equal_range visits duplicates in insertion order
+        iterator lower_bound(const key_type& key) { return iterator(lowerBoundHelper(key), this); }
+        const_iterator lower_bound(const key_type& key) const { return const_iterator(lowerBoundHelper(key), this); }
+        iterator upper_bound(const key_type& key) { return iterator(upperBoundHelper(key), this); }
+        const_iterator upper_bound(const key_type& key) const { return const_iterator(upperBoundHelper(key), this); }
+        std::pair<iterator, iterator> equal_range(const key_type& key) {
+            return std::make_pair(lower_bound(key), upper_bound(key));
+        }
+        std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+            return std::make_pair(lower_bound(key), upper_bound(key));
+        }
 
         // Tree printing based on traversals
         std::ostream& print_preorder(std::ostream& out) { 
@@ -450,117 +1452,114 @@ class Red_Black_Tree {
             return out;
         }
 
-        /* Prints a tree level-by-level in the format:
-        
-               3                  
+        /* Writes the shape of the tree to out in level order. Level format looks like:
+
+               3
               / \                 3[color]
-             2   5         =>     2[color] 5[color] 
+             2   5         =>     2[color] 5[color]
             /   / \               1[color] X 4[color] 6[color]
-           1   4   6 
+           1   4   6
 
-           null children are repesented by X's in non-empty levels
+           X marks a missing child of a node on the level above, so only real nodes and their direct
+           null children are visited: O(n) time, and memory proportional to the widest level.
+           At most max_nodes nodes are written; a larger tree ends with a truncation marker.
+           Returns the number of nodes written
         */
-       /*
-        void print_level_by_level(std::ostream& out) {
-            if (_root == nullptr) {
-                return;
+        size_t dump(std::ostream& out, RB_Dump_Format format = RB_Dump_Format::Level, size_t max_nodes = SIZE_MAX) const {
+            RB_Dump_Sink sink(out);
+            std::ostream& buffer = sink.stream();
+
+            // Entries of the current and next level with their ids; a null entry is a missing child
+            std::vector<std::pair<const RB_Node*, size_t>> level;
+            std::vector<std::pair<const RB_Node*, size_t>> next;
+            size_t written = 0;
+            size_t nextId = 1; // Ids follow level order, so a node's id is also its position in the output
+            bool truncated = false;
+
+            if (format == RB_Dump_Format::Dot) {
+                buffer << "digraph Red_Black_Tree {\n";
+            } else if (format == RB_Dump_Format::Json) {
+                buffer << "{\"nodes\": [";
             }
 
-            std::queue<RB_Node*> q;
-            int node_per_level = 1;
-            std::string level_print = "";
-            bool done = false;
-
-            // Add root to queue
-            q.push(_root);
-
-            // Print while there are nodes
-            while (!q.empty() && !done) {
-                
-                // Print the appropriate nodes for the level
-                for (int i = 0; i < node_per_level; i++) {
-                    // Remover first node from queue
-                    RB_Node* temp = q.front();
-
-                    if (temp == nullptr) { // X represents nullptr child
-                        level_print += "X ";
-                        q.push(nullptr);
-                        q.push(nullptr);
-                    } else { // print a node and its color
-                        level_print += std::to_string(temp->value) + "[" + color_string(temp->color) + "] ";
-
-                        // Add the node's left and right children to queue
-                        q.push(temp->left_child);
-                        q.push(temp->right_child);
-                    }
+            if (_root != nullptr) {
+                level.emplace_back(_root, 0);
+            }
 
-                    // Remove the node from the queue when it is no longer needed
-                    q.pop();
-                }
+            while (!level.empty() && !truncated) {
+                bool nonNullChild = false;
+
+                for (const std::pair<const RB_Node*, size_t>& entry : level) {
+                    const RB_Node* n = entry.first;
+                    if (n == nullptr) { // Only the level format shows missing children
+                        if (format == RB_Dump_Format::Level) {
+                            buffer << "X ";
+                        }
+                        continue;
+                    }
 
-                done = true;
-                for (size_t i = 0; i < level_print.size(); i++) {
-                    // If the level string does not contain only X's it should be printed
-                    if (level_print.at(i) == '[') {
-                        out << level_print << std::endl;
-                        done = false;
+                    if (written == max_nodes) {
+                        truncated = true;
                         break;
                     }
+
+                    size_t left = n->left_child ? nextId++ : SIZE_MAX;
+                    size_t right = n->right_child ? nextId++ : SIZE_MAX;
+                    dumpNode(buffer, format, n, entry.second, left, right, max_nodes);
+                    written++;
+
+                    next.emplace_back(n->left_child, left);
+                    next.emplace_back(n->right_child, right);
+                    nonNullChild = nonNullChild || n->left_child || n->right_child;
+                    sink.maybeFlush();
                 }
 
-                // Each level can contain twice as much nodes as the previous
-                node_per_level *= 2;
-                level_print = "";
+                level.swap(next);
+                next.clear();
+                if (!nonNullChild) { // The next level would only hold X's
+                    level.clear();
+                } else if (format == RB_Dump_Format::Level && !truncated) {
+                    buffer << "\n";
+                }
             }
-        }
-        */
 
-        void print_level_by_level(std::ostream& out) {
-            if (_root == nullptr) {
-                return;
+            if (format == RB_Dump_Format::Level) {
+                buffer << (truncated ? "..." : "");
+            } else if (format == RB_Dump_Format::Dot) {
+                buffer << (truncated ? "    // truncated\n" : "") << "}\n";
+            } else {
+                buffer << "], \"truncated\": " << (truncated ? "true" : "false") << "}\n";
             }
 
-            std::queue<RB_Node*> q; // This queue contains elements from a level and its children
-            q.push(_root);
-            size_t elementsInLevel = 1; // Elements in the current level
-            bool nonNullChild = false;
-
-            while (elementsInLevel > 0) {
-                RB_Node* n = q.front();
-                q.pop();
-                elementsInLevel--;
-
-                if (n) {
-                    out << "(" << n->value.first << ", " << n->value.second << ")[" << color_string(n->color) << "] ";
-                    q.push(n->left_child);
-                    q.push(n->right_child);
-
-                    if (n->left_child || n->right_child) {
-                        nonNullChild = true;
-                    }
-                } else {
-                    out << "X ";
-                    q.push(nullptr); // Descendants of empty node
-                    q.push(nullptr);
-                }
+            return written;
+        }
 
-                if (elementsInLevel == 0) { // Reached the end of the level
-                    if (nonNullChild) { // The next level is non-empty
-                        out << std::endl;
-                        nonNullChild = false;
-                        elementsInLevel = q.size();
-                    }
-                }
-            }
+        // Prints a tree level-by-level (see dump)
+        void print_level_by_level(std::ostream& out) const {
+            dump(out);
         }
 };
 
 // Ouput operator for tree
-template <typename K, typename V, typename Comparator = std::less<K>>
-std::ostream& operator<<(std::ostream& out, Red_Black_Tree<K, V, Comparator>& rbt) {
+template <typename K, typename V, typename Comparator = std::less<K>, bool Multi = false, typename Hash = void>
+std::ostream& operator<<(std::ostream& out, const Red_Black_Tree<K, V, Comparator, Multi, Hash>& rbt) {
     rbt.print_level_by_level(out);
 
     return out;
 } 
 
+// Red-black tree that keeps every inserted pair, storing equal keys as separate nodes in insertion order
+template <typename K, typename V, typename Comparator = std::less<K>>
+using Red_Black_Multimap = Red_Black_Tree<K, V, Comparator, true>;
+
+// Red-black tree with a hash side index, so exact-key lookups take one probe while ordered operations use the tree
+// A probe that misses is confirmed by a tree search, so lookups stay correct even if keys equal under Comparator
+// hash differently; only hits are O(1), and misses cost the probe plus O(log n)
+template <typename K, typename V, typename Hash = std::hash<K>, typename Comparator = std::less<K>>
+using Indexed_Red_Black_Tree = Red_Black_Tree<K, V, Comparator, false, Hash>;
+
+// Red-black tree of keys only; nodes have no value field
+template <typename K, typename Comparator = std::less<K>>
+using Red_Black_Set = Red_Black_Tree<K, void, Comparator>;
+
 #endif
\ No newline at end of file
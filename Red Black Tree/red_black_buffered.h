@@ -0,0 +1,195 @@
+#ifndef RED_BLACK_BUFFERED_H
+#define RED_BLACK_BUFFERED_H
+#include <cstddef>
+#include <functional>
+#include <utility> // for std::pair
+#include <vector>
+#include "red_black.h"
+
+// This class describes a write-buffered Red_Black_Tree for write-heavy bursts.
+// insert appends to an unsorted buffer in O(1). The buffer is sorted and merged into the tree with
+// Red_Black_Tree::insert_batch when it fills or when any read happens, so reads always see buffered writes.
+// Reads flush through mutable state, so a const Buffered_Red_Black_Tree must not be shared between threads.
+template <typename K, typename V, typename Comparator = std::less<K>, bool Multi = false>
+class Buffered_Red_Black_Tree {
+    public:
+        using key_type = K;
+        using value_type = V;
+        using key_compare = Comparator;
+        using tree_type = Red_Black_Tree<K, V, Comparator, Multi>;
+        using pair = typename tree_type::pair;
+        using iterator = typename tree_type::iterator;
+        using const_iterator = typename tree_type::const_iterator;
+
+    private:
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        mutable tree_type _tree;
+        mutable std::vector<pair> _buffer; // Pending inserts in arrival order
+        size_t _capacity;                  // Buffer size that triggers a merge
+
+
+
+
+
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        // Merges the pending inserts into the tree
+        void flush() const {
+            if (!_buffer.empty()) {
+                _tree.insert_batch(std::move(_buffer));
+                _buffer.clear(); // Keeps its capacity for the next burst
+            }
+        }
+
+    public:
+        // Checks if tree is empty
+        bool empty() const {
+            return _tree.empty() && _buffer.empty();
+        }
+
+        // Makes tree empty, dropping pending inserts
+        void clear() {
+            _tree.clear();
+            _buffer.clear();
+        }
+
+        // Default constructor; capacity is the number of pending inserts that triggers a merge
+        explicit Buffered_Red_Black_Tree(size_t capacity = 1024): _capacity(capacity > 0 ? capacity : 1) {
+            _buffer.reserve(_capacity);
+        }
+
+        // Copy Constructor
+        Buffered_Red_Black_Tree(const Buffered_Red_Black_Tree& other): _tree(other._tree), _buffer(other._buffer), _capacity(other._capacity) {}
+
+        // Move Constructor
+        Buffered_Red_Black_Tree(Buffered_Red_Black_Tree&& other)
+         : _tree(std::move(other._tree)), _buffer(std::move(other._buffer)), _capacity(other._capacity) {
+            other._buffer.clear();
+        }
+
+        // Copy Assignment
+        Buffered_Red_Black_Tree& operator=(const Buffered_Red_Black_Tree& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            _tree = other._tree;
+            _buffer = other._buffer;
+            _capacity = other._capacity;
+
+            return *this;
+        }
+
+        // Move Assignment
+        Buffered_Red_Black_Tree& operator=(Buffered_Red_Black_Tree&& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            _tree = std::move(other._tree);
+            _buffer = std::move(other._buffer);
+            _capacity = other._capacity;
+            other._buffer.clear();
+
+            return *this;
+        }
+
+        // Returns the number of nodes in the tree (merges pending inserts first)
+        size_t size() const {
+            flush();
+            return _tree.size();
+        }
+
+        // Number of inserts waiting to be merged
+        size_t pending() const { return _buffer.size(); }
+
+        // Append value to the buffer, merging once it is full
+        void insert(const pair& x) {
+            _buffer.push_back(x);
+            if (_buffer.size() >= _capacity) {
+                flush();
+            }
+        }
+
+        void insert(pair&& x) {
+            _buffer.push_back(std::move(x));
+            if (_buffer.size() >= _capacity) {
+                flush();
+            }
+        }
+
+        // Merge an unsorted batch together with any pending inserts
+        template <typename InputIt>
+        void insert_batch(InputIt first, InputIt last) {
+            _buffer.insert(_buffer.end(), first, last);
+            flush();
+        }
+
+        // Merge pending inserts into the tree now
+        void commit() { flush(); }
+
+        // Reads and erases see every buffered insert
+        size_t erase(const key_type& key) {
+            flush();
+            return _tree.erase(key);
+        }
+
+        bool contains(const key_type& key) const {
+            flush();
+            return _tree.contains(key);
+        }
+
+        value_type& find(const key_type& key) {
+            flush();
+            return _tree.find(key);
+        }
+        const value_type& find(const key_type& key) const {
+            flush();
+            return _tree.find(key);
+        }
+
+        value_type& operator[](const key_type& key) { return find(key); }
+        const value_type& operator[](const key_type& key) const { return find(key); }
+
+        size_t count(const key_type& key) const {
+            flush();
+            return _tree.count(key);
+        }
+
+        iterator begin() {
+            flush();
+            return _tree.begin();
+        }
+        const_iterator begin() const {
+            flush();
+            return static_cast<const tree_type&>(_tree).begin();
+        }
+        iterator end() { return _tree.end(); }
+        const_iterator end() const { return static_cast<const tree_type&>(_tree).end(); }
+
+        iterator lower_bound(const key_type& key) {
+            flush();
+            return _tree.lower_bound(key);
+        }
+        iterator upper_bound(const key_type& key) {
+            flush();
+            return _tree.upper_bound(key);
+        }
+        std::pair<iterator, iterator> equal_range(const key_type& key) {
+            flush();
+            return _tree.equal_range(key);
+        }
+
+        // Direct access to the merged tree
+        tree_type& tree() {
+            flush();
+            return _tree;
+        }
+};
+
+#endif
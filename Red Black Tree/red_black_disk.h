@@ -0,0 +1,603 @@
+#ifndef RED_BLACK_DISK_H
+#define RED_BLACK_DISK_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility> // for std::pair
+#include <vector>
+#include "red_black.h"
+
+// This class describes a red-black tree whose nodes live in fixed-size pages of a local file, for indexes
+// larger than memory. Child links are node numbers that map to a page and slot instead of raw pointers.
+// A bounded buffer pool with CLOCK replacement caches hot pages; evicting a dirty page writes back every
+// dirty page that is also due for eviction, in page order. Page 0 holds a header, so a file can be reopened.
+// Nodes are stored as raw bytes, so keys and values must be trivially copyable. Lookups return copies,
+// because a page may be evicted as soon as another page is loaded.
+// Rotations and fixups are RB_Balance's, the same code Red_Black_Tree runs, over node numbers instead of pointers.
+// A failed seek, read, write or flush throws std::runtime_error. The file stream then stays failed, so the
+// tree should be discarded: every later page access throws as well.
+template <typename K, typename V, typename Comparator = std::less<K>, size_t PageSize = 4096>
+class Disk_Red_Black_Tree {
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "Disk nodes are stored as raw bytes, so keys and values must be trivially copyable");
+
+    public:
+        using key_type = K;
+        using value_type = V;
+        using key_compare = Comparator;
+        using pair = std::pair<key_type, value_type>;
+        using node_ref = uint64_t; // Node number; 0 is the null link
+
+        // Buffer pool counters since the tree was opened or the counters were reset
+        struct Page_Stats {
+            size_t fetches; // Page accesses through the pool
+            size_t reads;   // Misses that read a page from the file
+            size_t writes;  // Pages written back to the file, including the header
+        };
+
+    private:
+        // Color type to describe if a node is black or red
+        enum class Color : uint8_t {Red, Black};
+
+        // Node for Red-Black Tree, as stored in a page slot
+        struct RB_Node {
+            key_type key;
+            value_type value;
+            node_ref left_child;
+            node_ref right_child;
+            node_ref parent;
+            Color color;
+        };
+
+        // Page 0 of the file
+        struct Header {
+            uint64_t magic;
+            uint64_t page_size;
+            uint64_t node_size;
+            node_ref root;
+            node_ref leftmost;
+            node_ref rightmost;
+            uint64_t size;
+            uint64_t node_count; // Highest node number handed out
+            node_ref free_list;  // Erased nodes, linked through left_child
+        };
+
+        // A cached page
+        struct Frame {
+            uint64_t page;
+            bool valid;
+            bool dirty;
+            bool referenced; // CLOCK bit, set on every access
+            std::unique_ptr<char[]> data;
+        };
+
+        static constexpr uint64_t Magic = 0x52424449534b3031; // "RBDISK01"
+        static constexpr size_t SlotsPerPage = PageSize / sizeof(RB_Node);
+        static_assert(SlotsPerPage > 0, "A page must hold at least one node");
+        static_assert(sizeof(Header) <= PageSize, "A page must hold the file header");
+
+    public:
+        // Bidirectional in-order iterator. Dereferencing copies the pair out of its page, so there is no operator->
+        class const_iterator {
+            friend class Disk_Red_Black_Tree;
+
+            node_ref node;
+            const Disk_Red_Black_Tree* tree;
+
+            const_iterator(node_ref node, const Disk_Red_Black_Tree* tree): node{node}, tree{tree} {}
+
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = pair;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const pair*;
+                using reference = pair;
+
+                const_iterator(): node{0}, tree{nullptr} {}
+
+                pair operator*() const {
+                    RB_Node n = tree->load(node);
+                    return pair(n.key, n.value);
+                }
+
+                const_iterator& operator++() {
+                    node = tree->successor(node);
+                    return *this;
+                }
+                const_iterator operator++(int) {
+                    const_iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                // Decrementing end() moves to the largest node
+                const_iterator& operator--() {
+                    node = node == 0 ? tree->_header.rightmost : tree->predecessor(node);
+                    return *this;
+                }
+                const_iterator operator--(int) {
+                    const_iterator temp = *this;
+                    --*this;
+                    return temp;
+                }
+
+                friend bool operator==(const const_iterator& a, const const_iterator& b) { return a.node == b.node; }
+                friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a.node != b.node; }
+        };
+
+        using iterator = const_iterator;
+
+    private:
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        mutable std::fstream _file;
+        std::string _path;
+        mutable uint64_t _file_pages; // Pages the file holds; pages past its end have never been written
+        Header _header;
+        mutable std::vector<Frame> _frames;
+        mutable std::unordered_map<uint64_t, size_t> _page_table; // Page number to frame index
+        mutable size_t _clock_hand;
+        mutable Page_Stats _stats;
+        key_compare comp;
+
+
+
+
+
+        ///////////////////////////
+        // BUFFER POOL FUNCTIONS //
+        ///////////////////////////
+
+        // Throws if the last operation on the file failed
+        void checkFile(const char* action, uint64_t page) const {
+            if (!_file) {
+                throw std::runtime_error("Could not " + std::string(action) + " page " + std::to_string(page) + " of " + _path);
+            }
+        }
+
+        void writePage(uint64_t page, const char* data) const {
+            _file.seekp(static_cast<std::streamoff>(page * PageSize));
+            checkFile("seek to", page);
+            _file.write(data, PageSize);
+            checkFile("write", page);
+
+            _file_pages = std::max(_file_pages, page + 1);
+            _stats.writes++;
+        }
+
+        void readPage(uint64_t page, char* data) const {
+            _stats.reads++;
+
+            // Pages past the end of the file have never been written
+            if (page >= _file_pages) {
+                std::memset(data, 0, PageSize);
+                return;
+            }
+
+            _file.seekg(static_cast<std::streamoff>(page * PageSize));
+            checkFile("seek to", page);
+            _file.read(data, PageSize); // A short read inside the file fails too
+            checkFile("read", page);
+        }
+
+        // Writes back the given dirty frames in page order so the file sees mostly sequential writes
+        void writeBack(std::vector<size_t>& frames) const {
+            std::sort(frames.begin(), frames.end(), [this](size_t a, size_t b) { return _frames[a].page < _frames[b].page; });
+
+            for (size_t i : frames) {
+                writePage(_frames[i].page, _frames[i].data.get());
+                _frames[i].dirty = false;
+            }
+        }
+
+        // Picks a frame to reuse with the CLOCK algorithm
+        size_t evict() const {
+            while (true) {
+                Frame& frame = _frames[_clock_hand];
+                size_t index = _clock_hand;
+                _clock_hand = (_clock_hand + 1) % _frames.size();
+
+                if (!frame.valid) {
+                    return index;
+                }
+
+                if (frame.referenced) { // Second chance
+                    frame.referenced = false;
+                    continue;
+                }
+
+                if (frame.dirty) { // Batch the victim with every other dirty page the clock would take next
+                    std::vector<size_t> batch;
+                    for (size_t i = 0; i < _frames.size(); i++) {
+                        if (_frames[i].valid && _frames[i].dirty && !_frames[i].referenced) {
+                            batch.push_back(i);
+                        }
+                    }
+                    writeBack(batch);
+                }
+
+                _page_table.erase(frame.page);
+                frame.valid = false;
+                return index;
+            }
+        }
+
+        // Returns the cached bytes of a page, loading it if needed. Valid until the next fetch
+        char* fetch(uint64_t page, bool write) const {
+            typename std::unordered_map<uint64_t, size_t>::iterator it = _page_table.find(page);
+            size_t index;
+            _stats.fetches++;
+
+            if (it != _page_table.end()) {
+                index = it->second;
+            } else {
+                index = evict();
+                Frame& frame = _frames[index];
+                readPage(page, frame.data.get());
+                frame.page = page;
+                frame.valid = true;
+                frame.dirty = false;
+                _page_table[page] = index;
+            }
+
+            Frame& frame = _frames[index];
+            frame.referenced = true;
+            frame.dirty = frame.dirty || write;
+            return frame.data.get();
+        }
+
+        // Node numbers map to page (n - 1) / SlotsPerPage + 1, slot (n - 1) % SlotsPerPage
+        RB_Node load(node_ref n) const {
+            RB_Node node;
+            const char* page = fetch((n - 1) / SlotsPerPage + 1, false);
+            std::memcpy(&node, page + ((n - 1) % SlotsPerPage) * sizeof(RB_Node), sizeof(RB_Node));
+            return node;
+        }
+
+        void store(node_ref n, const RB_Node& node) {
+            char* page = fetch((n - 1) / SlotsPerPage + 1, true);
+            std::memcpy(page + ((n - 1) % SlotsPerPage) * sizeof(RB_Node), &node, sizeof(RB_Node));
+        }
+
+        node_ref allocate(const pair& x, node_ref parent) {
+            node_ref n;
+
+            if (_header.free_list != 0) {
+                n = _header.free_list;
+                _header.free_list = load(n).left_child;
+            } else {
+                n = ++_header.node_count;
+            }
+
+            store(n, RB_Node{x.first, x.second, 0, 0, parent, Color::Red});
+            return n;
+        }
+
+        void release(node_ref n) {
+            RB_Node node = load(n);
+            node.left_child = _header.free_list;
+            store(n, node);
+            _header.free_list = n;
+        }
+
+
+
+
+
+        ////////////////////
+        // NODE ACCESSORS //
+        ////////////////////
+
+        // Node-handle accessors for RB_Balance; each one loads (and a setter stores) the node's page
+        struct Reader {
+            using node = node_ref;
+
+            const Disk_Red_Black_Tree* tree;
+
+            node_ref left(node_ref n) const { return tree->load(n).left_child; }
+            node_ref right(node_ref n) const { return tree->load(n).right_child; }
+            node_ref parent(node_ref n) const { return tree->load(n).parent; }
+            bool isRed(node_ref n) const { return n != 0 && tree->load(n).color == Color::Red; }
+            node_ref root() const { return tree->_header.root; }
+        };
+
+        struct Links : Reader {
+            Disk_Red_Black_Tree* owner;
+
+            explicit Links(Disk_Red_Black_Tree* owner): Reader{owner}, owner(owner) {}
+
+            void setLeft(node_ref n, node_ref child) const {
+                RB_Node node = owner->load(n);
+                node.left_child = child;
+                owner->store(n, node);
+            }
+            void setRight(node_ref n, node_ref child) const {
+                RB_Node node = owner->load(n);
+                node.right_child = child;
+                owner->store(n, node);
+            }
+            void setParent(node_ref n, node_ref p) const {
+                RB_Node node = owner->load(n);
+                node.parent = p;
+                owner->store(n, node);
+            }
+            void setRed(node_ref n, bool red) const {
+                RB_Node node = owner->load(n);
+                node.color = red ? Color::Red : Color::Black;
+                owner->store(n, node);
+            }
+            void setRoot(node_ref n) const { owner->_header.root = n; }
+        };
+
+        using balance = RB_Balance<Links>;
+
+        // In-order neighbours of a node, found through the parent links
+        node_ref successor(node_ref n) const { return RB_Balance<Reader>::successor(Reader{this}, n); }
+        node_ref predecessor(node_ref n) const { return RB_Balance<Reader>::predecessor(Reader{this}, n); }
+
+
+
+
+
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        // Node with key x, or 0
+        node_ref findHelper(const key_type& x) const {
+            node_ref n = _header.root;
+
+            while (n != 0) {
+                RB_Node node = load(n);
+                if (comp(x, node.key)) { // If current node is greater, go left
+                    n = node.left_child;
+                } else if (comp(node.key, x)) { // If current node is smaller, go right
+                    n = node.right_child;
+                } else { // If at correct node, return it
+                    return n;
+                }
+            }
+
+            return 0;
+        }
+
+        // First node whose key is not less than x (upper: greater than x)
+        node_ref boundHelper(const key_type& x, bool upper) const {
+            node_ref n = _header.root;
+            node_ref result = 0;
+
+            while (n != 0) {
+                RB_Node node = load(n);
+                if (upper ? comp(x, node.key) : !comp(node.key, x)) {
+                    result = n;
+                    n = node.left_child;
+                } else {
+                    n = node.right_child;
+                }
+            }
+
+            return result;
+        }
+
+        void insertHelper(const pair& x) {
+            node_ref p = 0;
+            node_ref n = _header.root;
+            bool goLeft = false;
+
+            while (n != 0) {
+                RB_Node node = load(n);
+
+                if (comp(x.first, node.key)) { // If less than current node, move left
+                    goLeft = true;
+                } else if (!comp(node.key, x.first)) { // Equal keys overwrite
+                    node.value = x.second;
+                    store(n, node);
+                    return;
+                } else { // If more than current node, move right
+                    goLeft = false;
+                }
+
+                p = n;
+                n = goLeft ? node.left_child : node.right_child;
+            }
+
+            n = allocate(x, p);
+            _header.size++;
+
+            if (p == 0) {
+                _header.root = _header.leftmost = _header.rightmost = n;
+            } else if (goLeft) {
+                Links(this).setLeft(p, n);
+                if (p == _header.leftmost) { _header.leftmost = n; }
+            } else {
+                Links(this).setRight(p, n);
+                if (p == _header.rightmost) { _header.rightmost = n; }
+            }
+
+            balance::insertFixup(Links(this), n);
+        }
+
+        // Unlinks a node from the tree, releases its slot and restores the red-black properties
+        void eraseHelper(node_ref n) {
+            if (n == _header.leftmost) { _header.leftmost = successor(n); }
+            if (n == _header.rightmost) { _header.rightmost = predecessor(n); }
+
+            balance::erase(Links(this), n);
+            release(n);
+            _header.size--;
+        }
+
+        // Checks a cached extreme before it is used by min, max, pop_min or pop_max
+        static node_ref extremeHelper(node_ref n) {
+            if (n == 0) {
+                throw std::out_of_range("The tree is empty");
+            }
+            return n;
+        }
+
+        void resetHeader() {
+            std::memset(&_header, 0, sizeof(Header));
+            _header.magic = Magic;
+            _header.page_size = PageSize;
+            _header.node_size = sizeof(RB_Node);
+        }
+
+    public:
+        // Opens (or creates) the tree stored at path, caching up to cache_pages pages in memory
+        // Throws std::runtime_error if the file cannot be opened or does not hold a whole tree of this layout
+        explicit Disk_Red_Black_Tree(const std::string& path, size_t cache_pages = 256)
+         : _path(path), _file_pages(0), _clock_hand(0), _stats{0, 0, 0} {
+            _file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+            if (!_file.is_open()) { // Create the file if it does not exist yet
+                _file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            }
+            if (!_file.is_open()) {
+                throw std::runtime_error("Could not open " + path);
+            }
+
+            _file.seekg(0, std::ios::end);
+            std::streamoff bytes = _file.tellg();
+            if (!_file || bytes < 0) {
+                throw std::runtime_error("Could not find the size of " + path);
+            }
+            _file_pages = (static_cast<uint64_t>(bytes) + PageSize - 1) / PageSize;
+
+            std::unique_ptr<char[]> page(new char[PageSize]);
+            readPage(0, page.get());
+            std::memcpy(&_header, page.get(), sizeof(Header));
+
+            if (_header.magic == 0) {
+                resetHeader();
+            } else if (_header.magic != Magic || _header.page_size != PageSize || _header.node_size != sizeof(RB_Node)) {
+                throw std::runtime_error(path + " does not hold a tree with this key, value and page layout");
+            } else if (_header.node_count > 0 && (_header.node_count - 1) / SlotsPerPage + 1 >= _file_pages) {
+                throw std::runtime_error(path + " is shorter than the " + std::to_string(_header.node_count) + " nodes its header records");
+            }
+
+            _frames.resize(cache_pages > 0 ? cache_pages : 1);
+            for (Frame& frame : _frames) {
+                frame.page = 0;
+                frame.valid = frame.dirty = frame.referenced = false;
+                frame.data.reset(new char[PageSize]);
+            }
+        }
+
+        // The tree owns its file and cache, so it cannot be copied
+        Disk_Red_Black_Tree(const Disk_Red_Black_Tree&) = delete;
+        Disk_Red_Black_Tree& operator=(const Disk_Red_Black_Tree&) = delete;
+
+        // Destructor writes back every dirty page. A destructor cannot throw, so call flush() first to see errors
+        ~Disk_Red_Black_Tree() {
+            try {
+                flush();
+            } catch (const std::runtime_error&) {
+            }
+        }
+
+        // Writes every dirty page and the header to the file. Throws std::runtime_error if a write fails
+        void flush() {
+            std::vector<size_t> batch;
+            for (size_t i = 0; i < _frames.size(); i++) {
+                if (_frames[i].valid && _frames[i].dirty) {
+                    batch.push_back(i);
+                }
+            }
+            writeBack(batch);
+
+            std::unique_ptr<char[]> page(new char[PageSize]());
+            std::memcpy(page.get(), &_header, sizeof(Header));
+            writePage(0, page.get());
+            _file.flush();
+            if (!_file) {
+                throw std::runtime_error("Could not flush " + _path);
+            }
+        }
+
+        // Checks if tree is empty
+        bool empty() const {
+            return _header.size == 0;
+        }
+
+        // Makes tree empty. Pages already in the file are reused by later inserts
+        void clear() {
+            resetHeader();
+            _page_table.clear();
+            for (Frame& frame : _frames) {
+                frame.valid = frame.dirty = frame.referenced = false;
+            }
+        }
+
+        // Buffer pool counters, for sizing cache_pages against a working set
+        Page_Stats page_stats() const { return _stats; }
+        void reset_page_stats() { _stats = Page_Stats{0, 0, 0}; }
+
+        // Returns the number of nodes in the tree
+        size_t size() const { return _header.size; }
+        size_t count() const { return _header.size; }
+        size_t count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+        // Insert value into tree and rebalance
+        void insert(const pair& x) { insertHelper(x); }
+
+        // Remove the node with the given key. Returns the number of nodes removed
+        size_t erase(const key_type& key) {
+            node_ref n = findHelper(key);
+            if (n == 0) {
+                return 0;
+            }
+
+            eraseHelper(n);
+            return 1;
+        }
+
+        // Returns true if value is in tree
+        bool contains(const key_type& x) const {
+            return findHelper(x) != 0;
+        }
+
+        // Find a copy of the value with a given key. Throws std::out_of_range if the key is missing
+        value_type find(const key_type& key) const {
+            node_ref n = findHelper(key);
+            if (n == 0) {
+                throw std::out_of_range("Key is not in the tree");
+            }
+            return load(n).value;
+        }
+
+        value_type operator[](const key_type& key) const { return find(key); }
+
+        // Smallest and largest pairs in O(1) page accesses. The tree must not be empty
+        pair min() const { return *const_iterator(extremeHelper(_header.leftmost), this); }
+        pair max() const { return *const_iterator(extremeHelper(_header.rightmost), this); }
+
+        // Remove and return the smallest or largest pair
+        pair pop_min() {
+            pair x = min();
+            eraseHelper(_header.leftmost);
+            return x;
+        }
+        pair pop_max() {
+            pair x = max();
+            eraseHelper(_header.rightmost);
+            return x;
+        }
+
+        // In-order iteration
+        const_iterator begin() const { return const_iterator(_header.leftmost, this); }
+        const_iterator end() const { return const_iterator(0, this); }
+        const_iterator lower_bound(const key_type& key) const { return const_iterator(boundHelper(key, false), this); }
+        const_iterator upper_bound(const key_type& key) const { return const_iterator(boundHelper(key, true), this); }
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef RED_BLACK_MERGE_H
+#define RED_BLACK_MERGE_H
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility> // for std::pair
+#include <vector>
+#include "red_black.h"
+#if __cplusplus >= 202002L
+#include <ranges>
+#endif
+
+// This class describes a lazy, globally ordered view over many Red_Black_Trees of the same type.
+// Each tree contributes a cursor into its own in-order iteration, and a binary min-heap of the k cursors
+// yields the next smallest pair in O(log k) per step, so nothing is copied or materialized and a loop
+// can stop at any point. Pairs with equal keys come out in the order the trees were given.
+// The trees must outlive the merge and must not be modified while it is being iterated.
+// In C++20 the merge is a std::ranges view, so it composes with std::views::filter, take and so on.
+template <typename Tree>
+class Red_Black_Merge
+#if __cplusplus >= 202002L
+ : public std::ranges::view_interface<Red_Black_Merge<Tree>>
+#endif
+{
+    public:
+        using tree_type = Tree;
+        using key_type = typename Tree::key_type;
+        using key_compare = typename Tree::key_compare;
+        using pair = typename Tree::pair;
+        using tree_iterator = typename Tree::const_iterator;
+
+    private:
+        using element = RB_Element<key_type, typename Tree::value_type>;
+
+        // Position in one tree; index breaks ties between equal keys
+        struct Cursor {
+            const Tree* tree;
+            tree_iterator position;
+            size_t index;
+        };
+
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        std::vector<const Tree*> _trees;
+        key_compare comp;
+
+    public:
+        // Forward iteration over the merged stream. Copying an iterator copies its k cursors
+        class iterator {
+            friend class Red_Black_Merge;
+
+            std::vector<Cursor> heap; // Min-heap on (key, index); empty at the end
+            key_compare comp;
+
+            // Heap order: true if a should come out after b
+            struct After {
+                const key_compare* comp;
+
+                bool operator()(const Cursor& a, const Cursor& b) const {
+                    const key_type& ka = element::key(*a.position);
+                    const key_type& kb = element::key(*b.position);
+                    if ((*comp)(kb, ka)) {
+                        return true;
+                    }
+                    return !(*comp)(ka, kb) && a.index > b.index;
+                }
+            };
+
+            iterator(std::vector<Cursor> cursors, const key_compare& comp): heap(std::move(cursors)), comp(comp) {
+                std::make_heap(heap.begin(), heap.end(), After{&this->comp});
+            }
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = pair;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const pair*;
+                using reference = const pair&;
+
+                iterator() = default;
+
+                reference operator*() const { return *heap.front().position; }
+                pointer operator->() const { return &*heap.front().position; }
+
+                // Moves the smallest cursor forward and restores the heap in O(log k)
+                iterator& operator++() {
+                    std::pop_heap(heap.begin(), heap.end(), After{&comp});
+                    Cursor& last = heap.back();
+
+                    if (++last.position == last.tree->end()) {
+                        heap.pop_back();
+                    } else {
+                        std::push_heap(heap.begin(), heap.end(), After{&comp});
+                    }
+
+                    return *this;
+                }
+                iterator operator++(int) {
+                    iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+
+                // Skips ahead to the first pair whose key is not less than key
+                // Only cursors behind key are moved, each with one lower_bound on its tree
+                iterator& seek(const key_type& key) {
+                    size_t kept = 0;
+
+                    for (size_t i = 0; i < heap.size(); i++) {
+                        Cursor cursor = heap[i];
+                        if (comp(element::key(*cursor.position), key)) {
+                            cursor.position = cursor.tree->lower_bound(key);
+                        }
+                        if (cursor.position != cursor.tree->end()) {
+                            heap[kept++] = cursor;
+                        }
+                    }
+
+                    heap.resize(kept);
+                    std::make_heap(heap.begin(), heap.end(), After{&comp});
+                    return *this;
+                }
+
+                // Iterators are equal when both are exhausted or both stand on the same pair
+                friend bool operator==(const iterator& a, const iterator& b) {
+                    if (a.heap.empty() || b.heap.empty()) {
+                        return a.heap.empty() == b.heap.empty();
+                    }
+                    return a.heap.size() == b.heap.size() && a.heap.front().position == b.heap.front().position;
+                }
+                friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+        };
+
+        using const_iterator = iterator;
+
+    private:
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        // Builds an iterator from one starting position per tree, skipping exhausted trees
+        template <typename Start>
+        iterator makeIterator(Start start) const {
+            std::vector<Cursor> cursors;
+            cursors.reserve(_trees.size());
+
+            for (size_t i = 0; i < _trees.size(); i++) {
+                tree_iterator position = start(*_trees[i]);
+                if (position != _trees[i]->end()) {
+                    cursors.push_back(Cursor{_trees[i], position, i});
+                }
+            }
+
+            return iterator(std::move(cursors), comp);
+        }
+
+    public:
+        Red_Black_Merge() = default;
+
+        // Merges the given trees; null pointers are skipped
+        explicit Red_Black_Merge(std::vector<const Tree*> trees, key_compare comp = key_compare()): comp(comp) {
+            for (const Tree* tree : trees) {
+                if (tree != nullptr) {
+                    _trees.push_back(tree);
+                }
+            }
+        }
+
+        // Merges every tree in [first, last)
+        template <typename InputIt>
+        Red_Black_Merge(InputIt first, InputIt last, key_compare comp = key_compare()): comp(comp) {
+            for (; first != last; ++first) {
+                _trees.push_back(&*first);
+            }
+        }
+
+        // Number of trees being merged
+        size_t tree_count() const { return _trees.size(); }
+
+        iterator begin() const {
+            return makeIterator([](const Tree& tree) { return tree.begin(); });
+        }
+        iterator end() const { return iterator(); }
+
+        // First merged pair whose key is not less (lower_bound) or greater (upper_bound) than key, in O(k log n)
+        iterator lower_bound(const key_type& key) const {
+            return makeIterator([&key](const Tree& tree) { return tree.lower_bound(key); });
+        }
+        iterator upper_bound(const key_type& key) const {
+            return makeIterator([&key](const Tree& tree) { return tree.upper_bound(key); });
+        }
+
+        // Calls fn on every merged pair with a key in [lo, hi), stopping early once the keys reach hi
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function fn) const {
+            for (iterator it = lower_bound(lo); it != end() && comp(element::key(*it), hi); ++it) {
+                fn(*it);
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,516 @@
+#ifndef RED_BLACK_SHARDED_H
+#define RED_BLACK_SHARDED_H
+#if __cplusplus < 201103L
+#error "red_black_sharded.h requires C++11"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility> // for std::pair
+#include <vector>
+#include "red_black.h"
+
+// This class describes a concurrent dictionary that splits the key space into ranges, each held by its
+// own Red_Black_Tree and lock, so writers to different ranges do not contend.
+// Shard i holds the keys in [boundary i - 1, boundary i). Because the ranges are disjoint and ordered,
+// visiting the shards in order yields a globally ordered stream without a heap-based merge.
+// An operation locks only the shard that owns its key. The boundaries are read under one of several small
+// route locks, picked per thread, so threads do not all write one lock word; each shard carries an epoch
+// that changes when one of its boundaries moves, and a lookup that raced such a move retries.
+// Every check_interval writes to a shard the shard sizes are compared, and if one shard holds more than
+// skew_factor times the average (or a shard is still unused), one boundary moves toward its equal-count
+// quantile, passing at most 2 * check_interval pairs between neighbouring shards. Only those two shards
+// are locked during the move, so writers never wait on a full redistribution.
+template <typename K, typename V, typename Comparator = std::less<K>>
+class Sharded_Red_Black_Tree {
+    public:
+        using key_type = K;
+        using value_type = V;
+        using key_compare = Comparator;
+        using tree_type = Red_Black_Tree<K, V, Comparator>;
+        using pair = typename tree_type::pair;
+
+    private:
+        // One key range and the lock that guards it
+        struct Shard {
+            mutable std::mutex lock;
+            tree_type tree;
+            size_t writes = 0; // Paces the rebalancing checks
+            size_t epoch = 0;  // Changes when a boundary of the shard moves; written under lock and every route lock
+        };
+
+        // Guards reads of the boundaries for the threads mapped to it. The padding keeps each lock on its own cache line
+        struct Route_Slot {
+            char padding[64];
+            std::mutex lock;
+        };
+
+        static constexpr size_t RouteSlots = 16;
+
+        // Holds every route slot, which stops all route lookups while a boundary changes
+        class Routes_Guard {
+            Route_Slot* _slots;
+
+            public:
+                explicit Routes_Guard(Route_Slot* slots): _slots(slots) {
+                    for (size_t i = 0; i < RouteSlots; i++) {
+                        _slots[i].lock.lock();
+                    }
+                }
+                ~Routes_Guard() {
+                    for (size_t i = RouteSlots; i > 0; i--) {
+                        _slots[i - 1].lock.unlock();
+                    }
+                }
+
+                Routes_Guard(const Routes_Guard&) = delete;
+                Routes_Guard& operator=(const Routes_Guard&) = delete;
+        };
+
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        std::vector<key_type> _boundaries; // Sorted; holds fewer than shard count - 1 keys until every shard is in use
+        std::vector<std::unique_ptr<Shard>> _shards;
+        size_t _check_interval;
+        size_t _skew_factor;
+        key_compare comp;
+
+        // Serializes boundary moves and the operations that need every shard at once. Lock order: this,
+        // then shards in index order, then the route slots
+        mutable std::mutex _rebalance_lock;
+        mutable Route_Slot _routes[RouteSlots];
+
+
+
+
+
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        // Index of the shard whose range holds key. Requires a route slot or _rebalance_lock
+        size_t shardIndex(const key_type& key) const {
+            size_t lo = 0;
+            size_t hi = _boundaries.size();
+
+            while (lo < hi) { // First boundary greater than key
+                size_t mid = lo + (hi - lo) / 2;
+                if (comp(key, _boundaries[mid])) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+
+            return lo;
+        }
+
+        // Route slot of the calling thread; threads are dealt out over the slots as they first call in
+        static size_t routeSlot() {
+            static std::atomic<size_t> next(0);
+            static thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed) % RouteSlots;
+            return slot;
+        }
+
+        // Locks the shard that owns key into guard and returns it
+        // The route is read under the thread's slot alone; if a boundary of the shard moved before the
+        // shard lock was taken, its epoch differs and the lookup is retried
+        Shard& lockShard(const key_type& key, std::unique_lock<std::mutex>& guard) const {
+            while (true) {
+                Shard* shard;
+                size_t epoch;
+                {
+                    std::lock_guard<std::mutex> route(_routes[routeSlot()].lock);
+                    shard = _shards[shardIndex(key)].get();
+                    epoch = shard->epoch;
+                }
+
+                guard = std::unique_lock<std::mutex>(shard->lock);
+                if (shard->epoch == epoch) {
+                    return *shard;
+                }
+                guard.unlock();
+            }
+        }
+
+        // Counts a write to a locked shard; true once every _check_interval writes
+        bool noteWrite(Shard& shard) const {
+            return ++shard.writes % _check_interval == 0;
+        }
+
+        // Current size of each shard, locking one at a time. Requires _rebalance_lock, so no pairs are in transit
+        std::vector<size_t> shardSizes() const {
+            std::vector<size_t> sizes;
+
+            for (const std::unique_ptr<Shard>& shard : _shards) {
+                std::lock_guard<std::mutex> shardGuard(shard->lock);
+                sizes.push_back(shard->tree.size());
+            }
+
+            return sizes;
+        }
+
+        // True if some shard is unused or the largest holds more than _skew_factor times the average
+        bool skewed(const std::vector<size_t>& sizes) const {
+            size_t total = 0;
+            size_t largest = 0;
+
+            for (size_t size : sizes) {
+                total += size;
+                largest = std::max(largest, size);
+            }
+
+            // Too few keys to be worth moving
+            if (total < _shards.size() * 64) {
+                return false;
+            }
+
+            // Shards left unused cost parallelism even when the active ones are even
+            if (_boundaries.size() + 1 < _shards.size()) {
+                return true;
+            }
+
+            return largest * _shards.size() > _skew_factor * total;
+        }
+
+        void createShards(size_t shard_count) {
+            for (size_t i = 0; i < (shard_count > 0 ? shard_count : 1); i++) {
+                _shards.emplace_back(new Shard());
+            }
+        }
+
+        // Sets boundary i and invalidates routes into the shards on either side. Requires _rebalance_lock and both shard locks
+        void publish(size_t i, const key_type& key) {
+            Routes_Guard routes(_routes);
+
+            _boundaries[i] = key;
+            _shards[i]->epoch++;
+            _shards[i + 1]->epoch++;
+        }
+
+        // Gives up to count of the largest pairs of shard i to the first unused shard, which then moves in
+        // right after it. The unused shard is unreachable until then, so only shard i blocks lookups. Requires _rebalance_lock
+        void split(size_t i, size_t count) {
+            size_t active = _boundaries.size() + 1;
+            Shard& from = *_shards[i];
+            Shard& to = *_shards[active];
+            std::lock_guard<std::mutex> fromGuard(from.lock);
+            std::lock_guard<std::mutex> toGuard(to.lock);
+
+            for (size_t moved = 0; moved < count && from.tree.size() > 1; moved++) {
+                to.tree.insert(from.tree.pop_max());
+            }
+            if (to.tree.empty()) {
+                return;
+            }
+
+            Routes_Guard routes(_routes);
+            std::rotate(_shards.begin() + i + 1, _shards.begin() + active, _shards.begin() + active + 1);
+            _boundaries.insert(_boundaries.begin() + i, to.tree.min().first);
+            from.epoch++;
+            to.epoch++;
+        }
+
+        // Moves up to count of the largest pairs of shard i to the front of shard i + 1. Requires _rebalance_lock
+        void moveUp(size_t i, size_t count) {
+            Shard& from = *_shards[i];
+            Shard& to = *_shards[i + 1];
+            std::lock_guard<std::mutex> fromGuard(from.lock);
+            std::lock_guard<std::mutex> toGuard(to.lock);
+
+            for (size_t moved = 0; moved < count && from.tree.size() > 1; moved++) {
+                to.tree.insert(from.tree.pop_max());
+            }
+            publish(i, to.tree.min().first);
+        }
+
+        // Moves up to count of the smallest pairs of shard i to the back of shard i - 1. Requires _rebalance_lock
+        void moveDown(size_t i, size_t count) {
+            Shard& to = *_shards[i - 1];
+            Shard& from = *_shards[i];
+            std::lock_guard<std::mutex> toGuard(to.lock);
+            std::lock_guard<std::mutex> fromGuard(from.lock);
+
+            for (size_t moved = 0; moved < count && from.tree.size() > 1; moved++) {
+                to.tree.insert(from.tree.pop_min());
+            }
+            publish(i - 1, from.tree.min().first);
+        }
+
+        // One bounded rebalancing step. While some shards are unused, the largest shard is split with an
+        // empty one. Otherwise the boundary whose running count is furthest from its equal-count quantile
+        // moves toward it. At most limit pairs change shards. Requires _rebalance_lock
+        void rebalanceStep(const std::vector<size_t>& sizes, size_t limit) {
+            size_t active = _boundaries.size() + 1;
+
+            if (active < _shards.size()) {
+                size_t largest = 0;
+                for (size_t i = 1; i < active; i++) {
+                    if (sizes[i] > sizes[largest]) {
+                        largest = i;
+                    }
+                }
+
+                if (sizes[largest] >= 2) {
+                    split(largest, std::min(sizes[largest] / 2, limit));
+                }
+                return;
+            }
+
+            size_t total = 0;
+            for (size_t size : sizes) {
+                total += size;
+            }
+
+            size_t prefix = 0;   // Pairs in shards [0, i]
+            size_t best = 0;     // Boundary to move
+            size_t distance = 0; // Its distance from the quantile
+            bool up = false;     // True if pairs should move from shard best to best + 1
+
+            for (size_t i = 0; i + 1 < _shards.size(); i++) {
+                prefix += sizes[i];
+                size_t quantile = (i + 1) * total / _shards.size();
+                bool tooMany = prefix > quantile;
+                size_t d = tooMany ? prefix - quantile : quantile - prefix;
+                size_t donor = sizes[tooMany ? i : i + 1];
+
+                if (d > distance && donor > 1) { // Donors keep one pair so the boundary stays defined
+                    best = i;
+                    distance = d;
+                    up = tooMany;
+                }
+            }
+
+            if (distance == 0) {
+                return;
+            }
+
+            if (up) {
+                moveUp(best, std::min(distance, limit));
+            } else {
+                moveDown(best + 1, std::min(distance, limit));
+            }
+        }
+
+        // Takes one rebalancing step if the shards are skewed, unless another thread is already rebalancing
+        // A step moves up to twice as many pairs as the shard took writes since its last check, so it
+        // outpaces a single hot range while adding amortized O(log n) work per write
+        void rebalanceCheck() {
+            std::unique_lock<std::mutex> guard(_rebalance_lock, std::try_to_lock);
+            if (!guard.owns_lock()) {
+                return;
+            }
+
+            std::vector<size_t> sizes = shardSizes();
+            if (skewed(sizes)) {
+                rebalanceStep(sizes, 2 * _check_interval);
+            }
+        }
+
+    public:
+        // Creates shard_count shards. Every key falls into the first shard until rebalancing steps split it
+        explicit Sharded_Red_Black_Tree(size_t shard_count, size_t check_interval = 4096, size_t skew_factor = 2)
+         : _check_interval(check_interval > 0 ? check_interval : 1), _skew_factor(skew_factor > 1 ? skew_factor : 2) {
+            createShards(shard_count);
+        }
+
+        // Creates one shard per range between the given (deduplicated) keys
+        explicit Sharded_Red_Black_Tree(std::vector<key_type> boundaries, size_t check_interval = 4096, size_t skew_factor = 2)
+         : _check_interval(check_interval > 0 ? check_interval : 1), _skew_factor(skew_factor > 1 ? skew_factor : 2) {
+            std::sort(boundaries.begin(), boundaries.end(), comp);
+            boundaries.erase(std::unique(boundaries.begin(), boundaries.end(),
+                                         [this](const key_type& a, const key_type& b) { return !comp(a, b) && !comp(b, a); }),
+                             boundaries.end());
+            _boundaries = std::move(boundaries);
+            createShards(_boundaries.size() + 1);
+        }
+
+        // Shards hold locks, so the container is neither copyable nor movable
+        Sharded_Red_Black_Tree(const Sharded_Red_Black_Tree&) = delete;
+        Sharded_Red_Black_Tree& operator=(const Sharded_Red_Black_Tree&) = delete;
+
+        // Returns the number of pairs across all shards
+        size_t size() const {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+            size_t total = 0;
+
+            for (size_t size : shardSizes()) {
+                total += size;
+            }
+
+            return total;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // Number of pairs in each shard, in key order
+        std::vector<size_t> shard_sizes() const {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+            return shardSizes();
+        }
+
+        // Makes every shard empty; boundaries are kept
+        void clear() {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+
+            for (std::unique_ptr<Shard>& shard : _shards) {
+                std::lock_guard<std::mutex> shardGuard(shard->lock);
+                shard->tree.clear();
+            }
+        }
+
+        // Insert value into the shard that owns its key
+        void insert(const pair& x) {
+            bool check;
+            {
+                std::unique_lock<std::mutex> shardGuard;
+                Shard& shard = lockShard(x.first, shardGuard);
+                shard.tree.insert(x);
+                check = noteWrite(shard);
+            }
+            if (check) {
+                rebalanceCheck();
+            }
+        }
+
+        void insert(pair&& x) {
+            bool check;
+            {
+                std::unique_lock<std::mutex> shardGuard;
+                Shard& shard = lockShard(x.first, shardGuard);
+                shard.tree.insert(std::move(x));
+                check = noteWrite(shard);
+            }
+            if (check) {
+                rebalanceCheck();
+            }
+        }
+
+        // Remove the pair with the given key. Returns the number of pairs removed
+        size_t erase(const key_type& key) {
+            size_t removed;
+            bool check;
+            {
+                std::unique_lock<std::mutex> shardGuard;
+                Shard& shard = lockShard(key, shardGuard);
+                removed = shard.tree.erase(key);
+                check = noteWrite(shard);
+            }
+            if (check) {
+                rebalanceCheck();
+            }
+            return removed;
+        }
+
+        // Returns true if key is in the map
+        bool contains(const key_type& key) const {
+            std::unique_lock<std::mutex> shardGuard;
+            const Shard& shard = lockShard(key, shardGuard);
+            return shard.tree.contains(key);
+        }
+
+        // Copies the value with the given key into out under the shard lock
+        // References cannot escape the lock, so this returns false instead when the key is missing
+        bool find(const key_type& key, value_type& out) const {
+            std::unique_lock<std::mutex> shardGuard;
+            const Shard& shard = lockShard(key, shardGuard);
+
+            typename tree_type::const_iterator it = shard.tree.lower_bound(key);
+            if (it == shard.tree.end() || comp(key, it->first)) {
+                return false;
+            }
+
+            out = it->second;
+            return true;
+        }
+
+        // Calls fn on every pair in key order. Each shard is locked while it is visited,
+        // and the boundaries cannot move during the walk
+        template <typename Function>
+        void for_each(Function fn) const {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+
+            for (const std::unique_ptr<Shard>& shard : _shards) {
+                std::lock_guard<std::mutex> shardGuard(shard->lock);
+                for (const pair& x : shard->tree) {
+                    fn(x);
+                }
+            }
+        }
+
+        // Calls fn on every pair with a key in [lo, hi) in key order, visiting only the shards that overlap the range
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function fn) const {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+
+            for (size_t i = shardIndex(lo), last = shardIndex(hi); i <= last && i < _shards.size(); i++) {
+                const Shard& shard = *_shards[i];
+                std::lock_guard<std::mutex> shardGuard(shard.lock);
+
+                for (typename tree_type::const_iterator it = shard.tree.lower_bound(lo); it != shard.tree.end() && comp(it->first, hi); ++it) {
+                    fn(*it);
+                }
+            }
+        }
+
+        // Moves every boundary to its equal-count quantile at once if the shards are skewed
+        // Blocks every other operation while the pairs are redistributed in O(n log n); writes only take bounded steps
+        void rebalance() {
+            std::lock_guard<std::mutex> guard(_rebalance_lock);
+            std::vector<std::unique_lock<std::mutex>> shardGuards;
+            std::vector<size_t> sizes;
+
+            for (std::unique_ptr<Shard>& shard : _shards) {
+                shardGuards.emplace_back(shard->lock);
+                sizes.push_back(shard->tree.size());
+            }
+
+            if (!skewed(sizes)) { // Another writer may have rebalanced first
+                return;
+            }
+
+            // Shards are disjoint and ordered, so popping each in turn yields every pair sorted
+            std::vector<pair> all;
+            for (std::unique_ptr<Shard>& shard : _shards) {
+                while (!shard->tree.empty()) {
+                    all.push_back(shard->tree.pop_min());
+                }
+            }
+
+            // Shard i starts at pair cuts[i]
+            std::vector<size_t> cuts(1, 0);
+            std::vector<key_type> boundaries;
+
+            for (size_t i = 1; i < _shards.size(); i++) {
+                size_t index = i * all.size() / _shards.size();
+                if (index > cuts.back()) {
+                    boundaries.push_back(all[index].first);
+                    cuts.push_back(index);
+                }
+            }
+            cuts.push_back(all.size());
+
+            {
+                Routes_Guard routes(_routes);
+                _boundaries.swap(boundaries);
+                for (std::unique_ptr<Shard>& shard : _shards) {
+                    shard->epoch++;
+                }
+            }
+
+            for (size_t i = 0; i + 1 < cuts.size(); i++) {
+                _shards[i]->tree.insert_batch(std::make_move_iterator(all.begin() + cuts[i]),
+                                              std::make_move_iterator(all.begin() + cuts[i + 1]));
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef RED_BLACK_SMALL_H
+#define RED_BLACK_SMALL_H
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility> // for std::pair
+#include "red_black.h"
+
+// This class describes a dictionary that keeps up to N key-value pairs inline in a sorted array.
+// Once an insert would exceed N pairs it promotes to a Red_Black_Tree, and it demotes back to the
+// array when the tree shrinks to N / 2 pairs (the gap keeps insert/erase at the threshold from thrashing).
+// Lookup, insertion and iteration behave the same in both modes.
+template <typename K, typename V, size_t N = 16, typename Comparator = std::less<K>>
+class Small_Red_Black_Tree {
+    static_assert(N > 0, "The inline buffer must hold at least one pair");
+
+    public:
+        using key_type = K;
+        using value_type = V;
+        using key_compare = Comparator;
+        using tree_type = Red_Black_Tree<K, V, Comparator>;
+        using pair = typename tree_type::pair;
+
+        // Bidirectional in-order iterator over either the inline array or the tree
+        template <bool Const>
+        class Small_Iterator {
+            friend class Small_Red_Black_Tree;
+            template <bool> friend class Small_Iterator;
+
+            using pair_pointer = typename std::conditional<Const, const pair*, pair*>::type;
+            using tree_iterator = typename std::conditional<Const, typename tree_type::const_iterator, typename tree_type::iterator>::type;
+
+            pair_pointer ptr;   // Position in the inline array (nullptr in tree mode)
+            tree_iterator it;   // Position in the tree
+
+            Small_Iterator(pair_pointer ptr, tree_iterator it): ptr{ptr}, it{it} {}
+
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = pair;
+                using difference_type = std::ptrdiff_t;
+                using pointer = pair_pointer;
+                using reference = typename std::conditional<Const, const pair&, pair&>::type;
+
+                Small_Iterator(): ptr{nullptr}, it{} {}
+
+                // Conversion from iterator to const_iterator
+                template <bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+                Small_Iterator(const Small_Iterator<OtherConst>& other): ptr{other.ptr}, it{other.it} {}
+
+                reference operator*() const { return ptr != nullptr ? *ptr : *it; }
+                pointer operator->() const { return &**this; }
+
+                Small_Iterator& operator++() {
+                    if (ptr != nullptr) { ++ptr; } else { ++it; }
+                    return *this;
+                }
+                Small_Iterator operator++(int) {
+                    Small_Iterator temp = *this;
+                    ++*this;
+                    return temp;
+                }
+                Small_Iterator& operator--() {
+                    if (ptr != nullptr) { --ptr; } else { --it; }
+                    return *this;
+                }
+                Small_Iterator operator--(int) {
+                    Small_Iterator temp = *this;
+                    --*this;
+                    return temp;
+                }
+
+                friend bool operator==(const Small_Iterator& a, const Small_Iterator& b) { return a.ptr == b.ptr && a.it == b.it; }
+                friend bool operator!=(const Small_Iterator& a, const Small_Iterator& b) { return !(a == b); }
+        };
+
+        using iterator = Small_Iterator<false>;
+        using const_iterator = Small_Iterator<true>;
+
+    private:
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        alignas(pair) unsigned char _storage[N * sizeof(pair)]; // Sorted inline pairs [0, _count)
+        size_t _count;
+        bool _promoted; // True while the pairs live in _tree
+        tree_type _tree;
+        key_compare comp;
+
+
+
+
+
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        pair* small() { return reinterpret_cast<pair*>(_storage); }
+        const pair* small() const { return reinterpret_cast<const pair*>(_storage); }
+
+        // Index of the first inline pair whose key is not less than x
+        // The scan is branch-free so it stays cheap (and vectorizable for scalar keys) at small N
+        size_t smallLowerBound(const key_type& x) const {
+            size_t index = 0;
+            for (size_t i = 0; i < _count; i++) {
+                index += comp(small()[i].first, x) ? 1 : 0;
+            }
+            return index;
+        }
+
+        // Index of the inline pair with key x, or _count if there is none
+        size_t smallFind(const key_type& x) const {
+            size_t index = smallLowerBound(x);
+            if (index < _count && !comp(x, small()[index].first)) {
+                return index;
+            }
+            return _count;
+        }
+
+        // Inserts into the inline array, or returns false if a new key does not fit
+        template <typename P>
+        bool smallInsert(P&& x) {
+            size_t index = smallLowerBound(x.first);
+
+            if (index < _count && !comp(x.first, small()[index].first)) { // Equal keys overwrite
+                small()[index] = std::forward<P>(x);
+                return true;
+            }
+
+            if (_count == N) {
+                return false;
+            }
+
+            // Shift the larger pairs up one slot
+            if (index == _count) {
+                new (small() + _count) pair(std::forward<P>(x));
+            } else {
+                new (small() + _count) pair(std::move(small()[_count - 1]));
+                for (size_t i = _count - 1; i > index; i--) {
+                    small()[i] = std::move(small()[i - 1]);
+                }
+                small()[index] = std::forward<P>(x);
+            }
+
+            _count++;
+            return true;
+        }
+
+        // Removes the inline pair at index, shifting the larger pairs down
+        void smallErase(size_t index) {
+            for (size_t i = index + 1; i < _count; i++) {
+                small()[i - 1] = std::move(small()[i]);
+            }
+            small()[_count - 1].~pair();
+            _count--;
+        }
+
+        void smallClear() {
+            for (size_t i = 0; i < _count; i++) {
+                small()[i].~pair();
+            }
+            _count = 0;
+        }
+
+        // Moves the inline pairs into the tree
+        void promote() {
+            for (size_t i = 0; i < _count; i++) {
+                _tree.insert(std::move(small()[i]));
+            }
+            smallClear();
+            _promoted = true;
+        }
+
+        // Moves the tree's pairs back into the inline array; in-order iteration keeps them sorted
+        void demote() {
+            for (pair& x : _tree) {
+                new (small() + _count) pair(std::move(x));
+                _count++;
+            }
+            _tree.clear();
+            _promoted = false;
+        }
+
+        // Copies the contents of other into this (empty) container
+        void copyFrom(const Small_Red_Black_Tree& other) {
+            if (other._promoted) {
+                _tree = other._tree;
+                _promoted = true;
+            } else {
+                for (size_t i = 0; i < other._count; i++) {
+                    new (small() + i) pair(other.small()[i]);
+                    _count++;
+                }
+            }
+        }
+
+        // Takes the contents of other, leaving it empty
+        void moveFrom(Small_Red_Black_Tree& other) {
+            if (other._promoted) {
+                _tree = std::move(other._tree);
+                _promoted = true;
+                other._promoted = false;
+            } else {
+                for (size_t i = 0; i < other._count; i++) {
+                    new (small() + i) pair(std::move(other.small()[i]));
+                    _count++;
+                }
+                other.smallClear();
+            }
+        }
+
+    public:
+        // Checks if container is empty
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // True while the pairs are stored in a red-black tree rather than inline
+        bool promoted() const { return _promoted; }
+
+        // Makes container empty and returns it to inline mode
+        void clear() {
+            smallClear();
+            _tree.clear();
+            _promoted = false;
+        }
+
+        // Default constructor
+        Small_Red_Black_Tree(): _count(0), _promoted(false) {}
+
+        // Copy Constructor
+        Small_Red_Black_Tree(const Small_Red_Black_Tree& other): _count(0), _promoted(false), comp(other.comp) {
+            copyFrom(other);
+        }
+
+        // Move Constructor
+        Small_Red_Black_Tree(Small_Red_Black_Tree&& other): _count(0), _promoted(false), comp(other.comp) {
+            moveFrom(other);
+        }
+
+        // Destructor
+        ~Small_Red_Black_Tree() {
+            smallClear();
+        }
+
+        // Copy Assignment
+        Small_Red_Black_Tree& operator=(const Small_Red_Black_Tree& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            clear();
+            comp = other.comp;
+            copyFrom(other);
+
+            return *this;
+        }
+
+        // Move Assignment
+        Small_Red_Black_Tree& operator=(Small_Red_Black_Tree&& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            clear();
+            comp = other.comp;
+            moveFrom(other);
+
+            return *this;
+        }
+
+        // Returns the number of pairs in the container
+        size_t size() const { return _promoted ? _tree.size() : _count; }
+
+        // Insert value, promoting to a tree if the inline array is full
+        void insert(const pair& x) {
+            if (_promoted) {
+                _tree.insert(x);
+            } else if (!smallInsert(x)) {
+                promote();
+                _tree.insert(x);
+            }
+        }
+
+        void insert(pair&& x) {
+            if (_promoted) {
+                _tree.insert(std::move(x));
+            } else if (!smallInsert(std::move(x))) { // x is only moved from when it fits
+                promote();
+                _tree.insert(std::move(x));
+            }
+        }
+
+        // Remove the pair with the given key, demoting to inline mode once the tree is small enough
+        // Returns the number of pairs removed
+        size_t erase(const key_type& key) {
+            if (!_promoted) {
+                size_t index = smallFind(key);
+                if (index == _count) {
+                    return 0;
+                }
+
+                smallErase(index);
+                return 1;
+            }
+
+            size_t removed = _tree.erase(key);
+            if (_tree.size() <= N / 2) {
+                demote();
+            }
+            return removed;
+        }
+
+        // Returns true if key is in container
+        bool contains(const key_type& key) const {
+            return _promoted ? _tree.contains(key) : smallFind(key) != _count;
+        }
+
+        // Find a value with a given key. Throws std::out_of_range if the key is missing
+        value_type& find(const key_type& key) {
+            iterator it = findIterator(key);
+            if (it == end()) {
+                throw std::out_of_range("Key is not in the tree");
+            }
+            return it->second;
+        }
+        const value_type& find(const key_type& key) const {
+            const_iterator it = findIterator(key);
+            if (it == end()) {
+                throw std::out_of_range("Key is not in the tree");
+            }
+            return it->second;
+        }
+
+        // Bracket access operator
+        value_type& operator[](const key_type& key) { return find(key); }
+        const value_type& operator[](const key_type& key) const { return find(key); }
+
+        // Iterator to the pair with the given key, or end()
+        iterator findIterator(const key_type& key) {
+            if (!_promoted) {
+                return iterator(small() + smallFind(key), typename tree_type::iterator());
+            }
+
+            typename tree_type::iterator it = _tree.lower_bound(key);
+            return iterator(nullptr, it != _tree.end() && !comp(key, it->first) ? it : _tree.end());
+        }
+        const_iterator findIterator(const key_type& key) const {
+            if (!_promoted) {
+                return const_iterator(small() + smallFind(key), typename tree_type::const_iterator());
+            }
+
+            typename tree_type::const_iterator it = _tree.lower_bound(key);
+            return const_iterator(nullptr, it != _tree.end() && !comp(key, it->first) ? it : _tree.end());
+        }
+
+        // In-order iteration
+        iterator begin() {
+            return _promoted ? iterator(nullptr, _tree.begin()) : iterator(small(), typename tree_type::iterator());
+        }
+        const_iterator begin() const {
+            return _promoted ? const_iterator(nullptr, _tree.begin()) : const_iterator(small(), typename tree_type::const_iterator());
+        }
+        iterator end() {
+            return _promoted ? iterator(nullptr, _tree.end()) : iterator(small() + _count, typename tree_type::iterator());
+        }
+        const_iterator end() const {
+            return _promoted ? const_iterator(nullptr, _tree.end()) : const_iterator(small() + _count, typename tree_type::const_iterator());
+        }
+};
+
+#endif
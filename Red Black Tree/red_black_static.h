@@ -0,0 +1,157 @@
+#ifndef RED_BLACK_STATIC_H
+#define RED_BLACK_STATIC_H
+#if __cplusplus < 201703L
+#error "red_black_static.h requires C++17"
+#endif
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility> // for std::pair
+
+// This class describes a read-only dictionary of N pairs built entirely at compile time.
+// The constructor sorts the pairs and lays the keys out in Eytzinger (BFS) order: the balanced search
+// tree a Red_Black_Tree would hold, flattened into an array where node i has children 2i + 1 and 2i + 2.
+// A lookup walks that array with no pointers, and declaring the tree constexpr puts it in a
+// read-only section with nothing to build at startup.
+// Keys and values are kept in separate arrays so a search only touches keys. Both types must be
+// literal and default constructible; duplicate keys throw (a compile error in a constant expression)
+template <typename K, typename V, size_t N, typename Comparator = std::less<K>>
+class Static_Red_Black_Tree {
+    public:
+        using key_type = K;
+        using value_type = V;
+        using key_compare = Comparator;
+        using pair = std::pair<K, V>;
+
+    private:
+        //////////////////////
+        // Member Variables //
+        //////////////////////
+
+        std::array<K, N> _keys;   // Eytzinger order
+        std::array<V, N> _values; // _values[i] belongs to _keys[i]
+        key_compare comp;
+
+
+
+
+
+        //////////////////////////////
+        // PRIVATE HELPER FUNCTIONS //
+        //////////////////////////////
+
+        // Restores the max-heap below root in order[0, count), ordering indices by their keys
+        constexpr void siftDown(const pair (&entries)[N], std::array<size_t, N>& order, size_t root, size_t count) const {
+            while (2 * root + 1 < count) {
+                size_t child = 2 * root + 1;
+                if (child + 1 < count && comp(entries[order[child]].first, entries[order[child + 1]].first)) {
+                    child++;
+                }
+                if (!comp(entries[order[root]].first, entries[order[child]].first)) {
+                    return;
+                }
+
+                size_t temp = order[root];
+                order[root] = order[child];
+                order[child] = temp;
+                root = child;
+            }
+        }
+
+        // Heapsort of the entry indices by key, so large tables stay within the compiler's constexpr step limit
+        constexpr std::array<size_t, N> sortedOrder(const pair (&entries)[N]) const {
+            std::array<size_t, N> order{};
+            for (size_t i = 0; i < N; i++) {
+                order[i] = i;
+            }
+
+            for (size_t i = N / 2; i > 0; i--) {
+                siftDown(entries, order, i - 1, N);
+            }
+            for (size_t end = N; end > 1; end--) {
+                size_t temp = order[0];
+                order[0] = order[end - 1];
+                order[end - 1] = temp;
+                siftDown(entries, order, 0, end - 1);
+            }
+
+            return order;
+        }
+
+        // In-order walk of the implicit tree rooted at slot k (1-based), filling it with the sorted entries
+        constexpr void layout(const pair (&entries)[N], const std::array<size_t, N>& order, size_t& next, size_t k) {
+            if (k > N) {
+                return;
+            }
+
+            layout(entries, order, next, 2 * k);
+            _keys[k - 1] = entries[order[next]].first;
+            _values[k - 1] = entries[order[next]].second;
+            next++;
+            layout(entries, order, next, 2 * k + 1);
+        }
+
+        // Slot holding key, or N if there is none
+        constexpr size_t findIndex(const key_type& key) const {
+            size_t k = 1;
+            while (k <= N) { // Branch-free descent; k records the path taken
+                k = 2 * k + (comp(_keys[k - 1], key) ? 1 : 0);
+            }
+
+            // Undoing the trailing right turns and the last left turn leaves the lower bound
+            while (k & 1) {
+                k >>= 1;
+            }
+            k >>= 1;
+
+            return k != 0 && !comp(key, _keys[k - 1]) ? k - 1 : N;
+        }
+
+    public:
+        // Builds the tree from N pairs in any order. Throws std::invalid_argument on duplicate keys
+        constexpr Static_Red_Black_Tree(const pair (&entries)[N], Comparator comp = Comparator())
+         : _keys{}, _values{}, comp(comp) {
+            std::array<size_t, N> order = sortedOrder(entries);
+
+            for (size_t i = 1; i < N; i++) {
+                if (!comp(entries[order[i - 1]].first, entries[order[i]].first)) {
+                    throw std::invalid_argument("Duplicate key in static tree");
+                }
+            }
+
+            size_t next = 0;
+            layout(entries, order, next, 1);
+        }
+
+        // Returns the number of pairs
+        constexpr size_t size() const { return N; }
+        constexpr bool empty() const { return N == 0; }
+
+        // Returns true if key is in the tree
+        constexpr bool contains(const key_type& key) const {
+            return findIndex(key) != N;
+        }
+
+        // Find a value with a given key. Throws std::out_of_range if the key is missing
+        constexpr const value_type& find(const key_type& key) const {
+            size_t index = findIndex(key);
+            if (index == N) {
+                throw std::out_of_range("Key is not in the tree");
+            }
+            return _values[index];
+        }
+
+        // Bracket access operator
+        constexpr const value_type& operator[](const key_type& key) const { return find(key); }
+};
+
+// Builds a Static_Red_Black_Tree, deducing N from the number of pairs:
+//     constexpr auto opcodes = make_static_red_black_tree<std::string_view, int>({{"add", 1}, {"sub", 2}});
+template <typename K, typename V, typename Comparator = std::less<K>, size_t N>
+constexpr Static_Red_Black_Tree<K, V, N, Comparator> make_static_red_black_tree(const std::pair<K, V> (&entries)[N],
+                                                                                 Comparator comp = Comparator()) {
+    return Static_Red_Black_Tree<K, V, N, Comparator>(entries, comp);
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Buffer pool benchmark for Disk_Red_Black_Tree with cache sizes below and above the working set.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I"Red Black Tree" bench/disk_bench.cpp -o disk_bench
+// Usage: disk_bench [pairs] [operations] [file]
+// The tree is built once with keys inserted in random order. The workload then touches a hot 2% of the
+// keys (80% lookups, 20% overwrites). Its working set is measured as the distinct pages it reads with an
+// unbounded cache, and the same workload is replayed with cache_pages from 1/8 to 2x that size.
+// The file is left in the OS page cache, so misses cost a system call rather than a device read.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "red_black_disk.h"
+
+using Clock = std::chrono::steady_clock;
+using Tree = Disk_Red_Black_Tree<int64_t, int64_t>;
+
+// Replays the same hot-key workload; returns the wall time in seconds
+static double replay(Tree& tree, const std::vector<int64_t>& hot, size_t operations) {
+    std::mt19937 g(42);
+    int64_t sum = 0;
+    Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < operations; i++) {
+        int64_t key = hot[g() % hot.size()];
+        if (g() % 5 == 0) {
+            tree.insert({key, static_cast<int64_t>(i)});
+        } else {
+            sum += tree.find(key);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (sum == 42) { std::printf(" "); } // Keeps the lookups from being optimized away
+    return seconds;
+}
+
+int main(int argc, char** argv) {
+    size_t pairs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    size_t operations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500000;
+    std::string path = argc > 3 ? argv[3] : "disk_bench.rbt";
+    std::remove(path.c_str());
+
+    std::vector<int64_t> keys(pairs);
+    for (size_t i = 0; i < pairs; i++) {
+        keys[i] = static_cast<int64_t>(i);
+    }
+    std::mt19937 g(1);
+    std::shuffle(keys.begin(), keys.end(), g);
+
+    Clock::time_point start = Clock::now();
+    {
+        Tree tree(path, 4096);
+        for (int64_t key : keys) {
+            tree.insert({key, key});
+        }
+    }
+    std::printf("built %zu pairs in %.2fs\n", pairs, std::chrono::duration<double>(Clock::now() - start).count());
+
+    // Hot keys are a random 2% drawn independently of the insertion order, so their nodes are spread over the file
+    std::vector<int64_t> hot(keys);
+    std::shuffle(hot.begin(), hot.end(), g);
+    hot.resize(std::max<size_t>(1, pairs / 50));
+
+    size_t workingSet;
+    {
+        Tree tree(path, pairs); // Never evicts
+        replay(tree, hot, operations);
+        workingSet = tree.page_stats().reads;
+    }
+    std::printf("working set: %zu pages of 4 KiB\n\n", workingSet);
+
+    std::printf("%-12s %-8s %12s %12s %12s %10s %12s\n", "cache_pages", "x ws", "fetches", "file reads", "file writes", "miss %", "ops/s");
+    for (double ratio : {0.125, 0.25, 0.5, 1.0, 2.0}) {
+        size_t cache = std::max<size_t>(1, static_cast<size_t>(ratio * static_cast<double>(workingSet)));
+        Tree tree(path, cache);
+
+        replay(tree, hot, operations / 10); // Warm the cache
+        tree.flush();
+        tree.reset_page_stats();
+
+        double seconds = replay(tree, hot, operations);
+        tree.flush(); // Writes include the pages still dirty at the end
+        Tree::Page_Stats stats = tree.page_stats();
+        std::printf("%-12zu %-8.3f %12zu %12zu %12zu %9.2f%% %12.0f\n", cache, ratio, stats.fetches, stats.reads, stats.writes,
+                    100.0 * static_cast<double>(stats.reads) / static_cast<double>(stats.fetches), static_cast<double>(operations) / seconds);
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Thread-scaling benchmark for Sharded_Red_Black_Tree against one Red_Black_Tree behind a single mutex.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -pthread -I"Red Black Tree" bench/sharded_bench.cpp -o sharded_bench
+// Usage: sharded_bench [ops per thread] [shards]
+// Each thread inserts (80%) and erases (20%) keys. Uniform keys are spread over the whole key space;
+// skewed keys send 90% of the operations to 1% of it. Besides throughput, the slowest single operation
+// is reported, since that is where a rebalancing stall would show; on a machine with fewer cores than
+// threads it mostly measures preemption instead.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "red_black_sharded.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double seconds;
+    double worst; // Slowest single operation, in seconds
+};
+
+// Deterministic per-thread key stream
+static int nextKey(std::mt19937& g, bool skewed) {
+    const int space = 1 << 24;
+    if (skewed && g() % 10 != 0) {
+        return static_cast<int>(g() % (space / 100)); // Hot 1%
+    }
+    return static_cast<int>(g() % space);
+}
+
+// Runs threads workers that each call op(key, erase) ops times
+template <typename Op>
+static Result run(size_t threads, size_t ops, bool skewed, Op op) {
+    std::vector<std::thread> workers;
+    std::vector<double> worst(threads, 0);
+    Clock::time_point start = Clock::now();
+
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 g(static_cast<unsigned>(t + 1));
+            for (size_t i = 0; i < ops; i++) {
+                int key = nextKey(g, skewed);
+                bool erase = g() % 5 == 0;
+
+                Clock::time_point before = Clock::now();
+                op(key, erase);
+                worst[t] = std::max(worst[t], std::chrono::duration<double>(Clock::now() - before).count());
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    return Result{std::chrono::duration<double>(Clock::now() - start).count(), *std::max_element(worst.begin(), worst.end())};
+}
+
+int main(int argc, char** argv) {
+    size_t ops = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t shards = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+
+    std::printf("%u hardware threads, %zu ops per thread, %zu shards\n", std::thread::hardware_concurrency(), ops, shards);
+    std::printf("%-8s %-8s %14s %14s %14s %14s\n", "keys", "threads", "single Mops/s", "sharded Mops/s", "single worst", "sharded worst");
+
+    for (bool skewed : {false, true}) {
+        for (size_t threads : {1, 2, 4, 8}) {
+            Red_Black_Tree<int, int> single;
+            std::mutex lock;
+            Result a = run(threads, ops, skewed, [&](int key, bool erase) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (erase) { single.erase(key); } else { single.insert({key, key}); }
+            });
+
+            Sharded_Red_Black_Tree<int, int> sharded(shards);
+            Result b = run(threads, ops, skewed, [&](int key, bool erase) {
+                if (erase) { sharded.erase(key); } else { sharded.insert({key, key}); }
+            });
+
+            double total = static_cast<double>(threads * ops) / 1e6;
+            std::printf("%-8s %-8zu %14.2f %14.2f %12.3fms %12.3fms\n", skewed ? "skewed" : "uniform", threads,
+                        total / a.seconds, total / b.seconds, a.worst * 1e3, b.worst * 1e3);
+
+            if (threads == 8) {
+                std::vector<size_t> sizes = sharded.shard_sizes();
+                std::printf("    shard sizes after the run:");
+                for (size_t size : sizes) { std::printf(" %zu", size); }
+                std::printf("\n");
+            }
+        }
+    }
+
+    // A full redistribution, which rebalance() still does when called explicitly, for comparison with the
+    // bounded steps taken on the write path
+    Sharded_Red_Black_Tree<int, int> full(shards, static_cast<size_t>(-1) / 2);
+    std::mt19937 g(7);
+    for (size_t i = 0; i < 8 * ops; i++) {
+        full.insert({nextKey(g, false), 0});
+    }
+
+    Clock::time_point start = Clock::now();
+    full.rebalance();
+    std::printf("full rebalance() of %zu pairs from one shard: %.3fms\n", full.size(),
+                std::chrono::duration<double>(Clock::now() - start).count() * 1e3);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Benchmark for the inline string-key prefix on UUID and URL keys.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I"Red Black Tree" bench/string_key_bench.cpp -o string_key_bench
+// Usage: string_key_bench [keys] [seed]
+// Red_Black_Tree<std::string, int> (std::less, so nodes carry the prefix) is compared with the same tree
+// under Plain_Less, which orders strings identically but does not match the prefix policy.
+// Times are nanoseconds per operation: inserting every key, finding every key in random order, and
+// lower_bound on keys that are not in the tree.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "red_black.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Same order as std::less<std::string>, without the inline prefix
+struct Plain_Less {
+    bool operator()(const std::string& a, const std::string& b) const { return a < b; }
+};
+
+static std::string uuid(std::mt19937_64& g) {
+    static const char* hex = "0123456789abcdef";
+    std::string s(36, '-');
+    for (size_t i = 0; i < s.size(); i++) {
+        if (i != 8 && i != 13 && i != 18 && i != 23) {
+            s[i] = hex[g() & 0xF];
+        }
+    }
+    return s;
+}
+
+// URLs share their scheme and often their host, so the first bytes rarely tell keys apart
+static std::string url(std::mt19937_64& g) {
+    static const char* hosts[] = {"www.example.com", "api.example.com", "cdn.example.org", "shop.example.net"};
+    static const char* sections[] = {"products", "users", "blog/posts", "static/img", "search"};
+    return std::string(g() % 4 ? "https://" : "http://") + hosts[g() % 4] + "/" + sections[g() % 5] + "/" +
+           std::to_string(g() % 100000000) + "?ref=" + std::to_string(g() % 1000);
+}
+
+template <typename Tree>
+static void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& probes,
+                const std::vector<std::string>& misses) {
+    Tree tree;
+    long sum = 0;
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert({keys[i], static_cast<int>(i)});
+    }
+    Clock::time_point inserted = Clock::now();
+    for (const std::string& key : probes) {
+        sum += tree.find(key);
+    }
+    Clock::time_point found = Clock::now();
+    for (const std::string& key : misses) {
+        sum += tree.lower_bound(key) == tree.end() ? 0 : 1;
+    }
+    Clock::time_point bounded = Clock::now();
+
+    auto ns = [](Clock::time_point a, Clock::time_point b, size_t n) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / static_cast<double>(n);
+    };
+    std::printf("  %-22s insert %7.1f  find %7.1f  lower_bound miss %7.1f  (%ld)\n", name,
+                ns(start, inserted, keys.size()), ns(inserted, found, probes.size()), ns(found, bounded, misses.size()), sum);
+}
+
+template <typename Make>
+static void workload(const char* name, size_t n, unsigned seed, Make make) {
+    std::mt19937_64 g(seed);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(make(g));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), g);
+
+    std::vector<std::string> probes(keys);
+    std::shuffle(probes.begin(), probes.end(), g);
+    std::vector<std::string> misses;
+    for (size_t i = 0; i < n; i++) {
+        misses.push_back(make(g) + "~");
+    }
+
+    std::printf("%s (%zu keys, ns/op)\n", name, keys.size());
+    run<Red_Black_Tree<std::string, int>>("prefix (std::less)", keys, probes, misses);
+    run<Red_Black_Tree<std::string, int, Plain_Less>>("no prefix (Plain_Less)", keys, probes, misses);
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    unsigned seed = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    workload("UUID", n, seed, uuid);
+    workload("URL", n, seed, url);
+    return 0;
+}